@@ -1,3 +1,6 @@
+#ifndef BUTTON_H
+#define BUTTON_H
+
 #include "Reflectable.hpp"
 #include "json.hpp"
 
@@ -52,4 +55,6 @@ public:
     friend inline bool operator==(const Button &lhs, const Button &rhs) { return lhs.value_ == rhs.value_; }
     friend inline bool operator!=(const Button &lhs, const Button &rhs) { return !(lhs.value_ == rhs.value_); }
 };
-} // namespace Politocean
\ No newline at end of file
+} // namespace Politocean
+
+#endif //BUTTON_H
@@ -0,0 +1,307 @@
+#ifndef BUTTON_MAP_H
+#define BUTTON_MAP_H
+
+#include <string>
+#include <map>
+#include <fstream>
+#include <exception>
+
+#include "json.hpp"
+
+#include "PolitoceanConstants.h"
+#include "ComponentsManager.hpp"
+
+namespace Politocean
+{
+
+class ButtonMapException : public std::exception
+{
+    std::string msg_;
+
+public:
+    ButtonMapException(const std::string &msg) : msg_(msg) {}
+
+    virtual char const *what() const throw()
+    {
+        return msg_.c_str();
+    }
+};
+
+/**
+ * What a button publishes on press and on release.
+ * An empty @action means that nothing is published.
+ */
+struct ButtonAction
+{
+    std::string topic;
+    std::string action;
+};
+
+/**
+ * @PRESS_RELEASE : a press sends @press, a release sends @release.
+ * @POWER_TOGGLE  : a press sends @powerOff while the ROV power is enabled and @powerOn while it is disabled,
+ *                  a release sends nothing.
+ */
+enum class BindingKind
+{
+    PRESS_RELEASE,
+    POWER_TOGGLE
+};
+
+struct ButtonBinding
+{
+    BindingKind kind = BindingKind::PRESS_RELEASE;
+
+    ButtonAction press, release;
+    ButtonAction powerOn, powerOff;
+};
+
+/**
+ * Table which maps a joystick button id to the command it sends.
+ * It is resolved once at startup, from the defaults or from a JSON file, so that dispatching
+ * a button is a single lookup with no string built on the way.
+ *
+ * The file is an array of bindings, where topics, actions and buttons can be given by name:
+ *  [
+ *      { "button": "VUP", "topic": "COMMANDS", "press": "VUP_ON", "release": "VUP_OFF" },
+ *      { "button": 7, "topic": "COMMANDS", "press": "POWER_TOGGLE" }
+ *  ]
+ * Names which are not known are taken as literal topics or actions.
+ */
+class ButtonMap
+{
+public:
+    static const int MAX_BUTTONS = 128;
+
+private:
+    ButtonBinding bindings_[MAX_BUTTONS];
+
+    static const std::map<std::string, std::string> &topics()
+    {
+        using namespace Constants;
+        using namespace Constants::Commands;
+
+        static const std::map<std::string, std::string> names = {
+            {"COMMANDS", Topics::COMMANDS},
+            {"SHOULDER", Topics::SHOULDER},
+            {"WRIST", Topics::WRIST},
+            {"HAND", Topics::HAND},
+            {"HEAD", Topics::HEAD}};
+
+        return names;
+    }
+
+    static const std::map<std::string, std::string> &actions()
+    {
+        using namespace Constants;
+        using namespace Constants::Commands;
+
+        static const std::map<std::string, std::string> names = {
+            {"ON", Actions::ON},
+            {"OFF", Actions::OFF},
+            {"RESET", Actions::RESET},
+            {"START", Actions::START},
+            {"STOP", Actions::STOP},
+            {"UP", Actions::Stepper::UP},
+            {"DOWN", Actions::Stepper::DOWN},
+            {"START_AND_STOP", Actions::ATMega::START_AND_STOP},
+            {"VUP_ON", Actions::ATMega::VUP_ON},
+            {"VUP_OFF", Actions::ATMega::VUP_OFF},
+            {"VUP_FAST_ON", Actions::ATMega::VUP_FAST_ON},
+            {"VUP_FAST_OFF", Actions::ATMega::VUP_FAST_OFF},
+            {"VDOWN_ON", Actions::ATMega::VDOWN_ON},
+            {"VDOWN_OFF", Actions::ATMega::VDOWN_OFF},
+            {"SLOW", Actions::ATMega::SLOW},
+            {"MEDIUM", Actions::ATMega::MEDIUM},
+            {"FAST", Actions::ATMega::FAST},
+            {"PITCH_CONTROL", Actions::ATMega::PITCH_CONTROL}};
+
+        return names;
+    }
+
+    static const std::map<std::string, int> &buttons()
+    {
+        using namespace Constants;
+        using namespace Constants::Commands;
+
+        static const std::map<std::string, int> names = {
+            {"START_AND_STOP", Buttons::START_AND_STOP},
+            {"MOTORS", Buttons::MOTORS},
+            {"RESET", Buttons::RESET},
+            {"VUP", Buttons::VUP},
+            {"VUP_FAST", Buttons::VUP_FAST},
+            {"VDOWN", Buttons::VDOWN},
+            {"SLOW", Buttons::SLOW},
+            {"MEDIUM_FAST", Buttons::MEDIUM_FAST},
+            {"SHOULDER_ENABLE", Buttons::SHOULDER_ENABLE},
+            {"SHOULDER_DISABLE", Buttons::SHOULDER_DISABLE},
+            {"WRIST_ENABLE", Buttons::WRIST_ENABLE},
+            {"WRIST_DISABLE", Buttons::WRIST_DISABLE},
+            {"WRIST", Buttons::WRIST},
+            {"SHOULDER_UP", Buttons::SHOULDER_UP},
+            {"SHOULDER_DOWN", Buttons::SHOULDER_DOWN},
+            {"HAND", Buttons::HAND},
+            {"HEAD_ENABLE", Buttons::HEAD_ENABLE},
+            {"HEAD_DISABLE", Buttons::HEAD_DISABLE},
+            {"HEAD_UP", Buttons::HEAD_UP},
+            {"HEAD_DOWN", Buttons::HEAD_DOWN},
+            {"PITCH_CONTROL", Buttons::PITCH_CONTROL}};
+
+        return names;
+    }
+
+    static std::string lookup(const std::map<std::string, std::string> &names, const std::string &name)
+    {
+        auto it = names.find(name);
+        return it != names.end() ? it->second : name;
+    }
+
+    ButtonBinding &at(int id)
+    {
+        if (id < 0 || id >= MAX_BUTTONS)
+            throw ButtonMapException("Button id " + std::to_string(id) + " out of range.");
+
+        return bindings_[id];
+    }
+
+    void bind(int id, const std::string &topic, const std::string &press, const std::string &release = "")
+    {
+        ButtonBinding &binding = at(id);
+
+        binding = ButtonBinding();
+        binding.press = ButtonAction{topic, press};
+        binding.release = ButtonAction{topic, release};
+    }
+
+    void bindPowerToggle(int id, const std::string &topic)
+    {
+        using namespace Constants;
+        using namespace Constants::Commands;
+
+        ButtonBinding &binding = at(id);
+
+        binding = ButtonBinding();
+        binding.kind = BindingKind::POWER_TOGGLE;
+        binding.powerOn = ButtonAction{topic, Actions::ON};
+        binding.powerOff = ButtonAction{topic, Actions::OFF};
+    }
+
+public:
+    // The default mapping
+    ButtonMap()
+    {
+        using namespace Constants;
+        using namespace Constants::Commands;
+
+        bind(Buttons::START_AND_STOP, Topics::COMMANDS, Actions::ATMega::START_AND_STOP);
+        bindPowerToggle(Buttons::MOTORS, Topics::COMMANDS);
+        bind(Buttons::RESET, Topics::COMMANDS, Actions::RESET);
+        bind(Buttons::VUP, Topics::COMMANDS, Actions::ATMega::VUP_ON, Actions::ATMega::VUP_OFF);
+        bind(Buttons::VUP_FAST, Topics::COMMANDS, Actions::ATMega::VUP_FAST_ON, Actions::ATMega::VUP_FAST_OFF);
+        bind(Buttons::VDOWN, Topics::COMMANDS, Actions::ATMega::VDOWN_ON, Actions::ATMega::VDOWN_OFF);
+        bind(Buttons::SLOW, Topics::COMMANDS, Actions::ATMega::SLOW);
+        bind(Buttons::MEDIUM_FAST, Topics::COMMANDS, Actions::ATMega::MEDIUM, Actions::ATMega::FAST);
+        bind(Buttons::SHOULDER_ENABLE, Topics::SHOULDER, Actions::ON);
+        bind(Buttons::SHOULDER_DISABLE, Topics::SHOULDER, Actions::OFF);
+        bind(Buttons::WRIST_ENABLE, Topics::WRIST, Actions::ON);
+        bind(Buttons::WRIST_DISABLE, Topics::WRIST, Actions::OFF);
+        bind(Buttons::WRIST, Topics::WRIST, Actions::START, Actions::STOP);
+        bind(Buttons::SHOULDER_UP, Topics::SHOULDER, Actions::Stepper::UP, Actions::STOP);
+        bind(Buttons::SHOULDER_DOWN, Topics::SHOULDER, Actions::Stepper::DOWN, Actions::STOP);
+        bind(Buttons::HAND, Topics::HAND, Actions::START, Actions::STOP);
+        bind(Buttons::HEAD_ENABLE, Topics::HEAD, Actions::ON);
+        bind(Buttons::HEAD_DISABLE, Topics::HEAD, Actions::OFF);
+        bind(Buttons::HEAD_UP, Topics::HEAD, Actions::Stepper::UP, Actions::STOP);
+        bind(Buttons::HEAD_DOWN, Topics::HEAD, Actions::Stepper::DOWN, Actions::STOP);
+        bind(Buttons::PITCH_CONTROL, Topics::COMMANDS, Actions::ATMega::PITCH_CONTROL);
+    }
+
+    /**
+     * Replaces the whole mapping with the one in the @path JSON file.
+     * It throws a @ButtonMapException if the file cannot be read or parsed.
+     */
+    void load(const std::string &path)
+    {
+        std::ifstream file(path);
+        if (!file)
+            throw ButtonMapException("Cannot open button map \"" + path + "\".");
+
+        ButtonMap loaded;
+        for (ButtonBinding &binding : loaded.bindings_)
+            binding = ButtonBinding();
+
+        try
+        {
+            nlohmann::json j_bindings;
+            file >> j_bindings;
+
+            for (const auto &j_binding : j_bindings)
+            {
+                const nlohmann::json &j_button = j_binding.at("button");
+                int id;
+
+                if (j_button.is_string())
+                {
+                    auto it = buttons().find(j_button.get<std::string>());
+                    if (it == buttons().end())
+                        throw ButtonMapException("Unknown button \"" + j_button.get<std::string>() + "\".");
+                    id = it->second;
+                }
+                else
+                    id = j_button.get<int>();
+
+                std::string topic = lookup(topics(), j_binding.at("topic").get<std::string>());
+                std::string press = j_binding.count("press") ? j_binding.at("press").get<std::string>() : "";
+                std::string release = j_binding.count("release") ? j_binding.at("release").get<std::string>() : "";
+
+                if (press == "POWER_TOGGLE")
+                    loaded.bindPowerToggle(id, topic);
+                else
+                    loaded.bind(id, topic, lookup(actions(), press), lookup(actions(), release));
+            }
+        }
+        catch (const ButtonMapException &)
+        {
+            throw;
+        }
+        catch (const std::exception &e)
+        {
+            throw ButtonMapException("An error occurred while parsing button map: " + std::string(e.what()));
+        }
+
+        for (int id = 0; id < MAX_BUTTONS; id++)
+            bindings_[id] = loaded.bindings_[id];
+    }
+
+    /**
+     * Returns the action bound to button @id being pressed (@value 1) or released (@value 0),
+     * or nullptr if there is none.
+     */
+    const ButtonAction *resolve(int id, int value) const
+    {
+        if (id < 0 || id >= MAX_BUTTONS)
+            return nullptr;
+
+        const ButtonBinding &binding = bindings_[id];
+
+        if (binding.kind == BindingKind::POWER_TOGGLE)
+        {
+            if (!value)
+                return nullptr;
+
+            Component::Status power = ComponentsManager::GetComponentState(component_t::POWER);
+            if (power == Component::Status::ENABLED)
+                return &binding.powerOff;
+            if (power == Component::Status::DISABLED)
+                return &binding.powerOn;
+            return nullptr;
+        }
+
+        const ButtonAction &action = value ? binding.press : binding.release;
+        return action.action.empty() ? nullptr : &action;
+    }
+};
+
+} // namespace Politocean
+
+#endif //BUTTON_MAP_H
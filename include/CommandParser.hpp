@@ -0,0 +1,621 @@
+#ifndef COMMAND_PARSER_H
+#define COMMAND_PARSER_H
+
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <condition_variable>
+
+#include "PolitoceanConstants.h"
+#include <mqttLogger.h>
+
+#include "Reflectables/Vector.hpp"
+
+#include "Button.hpp"
+#include "ButtonMap.hpp"
+#include "JoystickFrame.hpp"
+#include "Diagnostics.hpp"
+#include "JsonPayload.hpp"
+#include "ControlFrame.hpp"
+#include "PublishScheduler.hpp"
+
+namespace Politocean
+{
+namespace CommandParser
+{
+
+/**************************************************************
+ * Axes state for the axes talker
+ *************************************************************/
+
+class AxesState
+{
+public:
+    static const int MAX_AXES = JoystickFrame::MAX_AXES;
+
+    /**
+     * @values are the axes just received, @prevValues the ones of the previous update.
+     * Fixed arrays: comparing them is a single branch-free pass.
+     */
+    int values[MAX_AXES] = {0};
+    int prevValues[MAX_AXES] = {0};
+
+    // Returns a mask with bit i set if axis i changed since the last update
+    uint32_t update()
+    {
+        uint32_t changed = 0;
+
+        for (int i = 0; i < MAX_AXES; i++)
+            changed |= (uint32_t)(values[i] != prevValues[i]) << i;
+
+        std::copy(values, values + MAX_AXES, prevValues);
+
+        return changed;
+    }
+
+    static uint32_t mask(int axis)
+    {
+        return 1U << axis;
+    }
+};
+
+/**
+ * Resolution an axis is reduced to before changes are looked for.
+ * @step        : width of a level in joystick units, 1 keeps the full resolution.
+ * @hysteresis  : how far past the middle of two levels an axis must go to switch level,
+ *                so that an axis resting on a boundary does not flicker between them.
+ *                Levels only hold against noise smaller than twice the hysteresis.
+ */
+struct Quantization
+{
+    int step;
+    int hysteresis;
+};
+
+const Quantization FULL_RESOLUTION = {1, 0};
+
+/**
+ * Maps axes onto the resolution the actuators actually use, so that wiggles smaller
+ * than a level are not changes at all. Levels are mapped back to the joystick range,
+ * clamped to ±32767 so that full deflection stays full.
+ */
+class AxisQuantizer
+{
+    Quantization quantization_[AxesState::MAX_AXES];
+    int levels_[AxesState::MAX_AXES] = {0};
+
+public:
+    AxisQuantizer()
+    {
+        set(FULL_RESOLUTION);
+    }
+
+    void set(const Quantization &quantization)
+    {
+        std::fill(quantization_, quantization_ + AxesState::MAX_AXES, quantization);
+    }
+
+    void set(int axis, const Quantization &quantization)
+    {
+        if (axis >= 0 && axis < AxesState::MAX_AXES)
+            quantization_[axis] = quantization;
+    }
+
+    // Quantizes AxesState::MAX_AXES @values in place
+    void apply(int *values)
+    {
+        for (int i = 0; i < AxesState::MAX_AXES; i++)
+        {
+            const Quantization &q = quantization_[i];
+            if (q.step <= 1)
+                continue;
+
+            // The level only moves once the axis is clearly out of it
+            if (std::abs(values[i] - levels_[i] * q.step) > q.step / 2 + q.hysteresis)
+                levels_[i] = (values[i] + (values[i] < 0 ? -q.step / 2 : q.step / 2)) / q.step;
+
+            values[i] = std::min(std::max(levels_[i] * q.step, -32767), 32767);
+        }
+    }
+};
+
+/**************************************************************
+ * Listener class for Joystick device
+ *************************************************************/
+
+class Listener
+{
+    static const std::size_t BUTTON_QUEUE_SIZE = 256;
+
+    /**
+     * Buttons with the time they were queued at, for the "commands.queue" latency.
+     * A ring of BUTTON_QUEUE_SIZE preallocated slots: queueing a button never allocates.
+     */
+    std::vector<std::pair<Button, uint64_t>> buttons_;
+    std::size_t buttonsHead_ = 0, buttonsCount_ = 0;
+
+    std::atomic<bool> isAxesUpdated_{false};
+
+    int axes_[AxesState::MAX_AXES] = {0};
+    int numAxes_ = 0;
+
+    std::mutex mutexBtn_, mutexAxes_;
+
+    // Notified with every button queued, so that the button talker does not have to poll
+    std::condition_variable buttonsCv_;
+
+    // Notified with every axes update, so that the axes talker does not have to poll either
+    std::condition_variable axesCv_;
+
+    /**
+     * @frame_ is the last binary frame received: buttons are published as the difference
+     * between its bitfield and the one of the next frame.
+     */
+    JoystickFrame frame_;
+    bool hasFrame_ = false;
+
+    // @mutexBtn_ must be held
+    void pushButton(const Button &button, uint64_t time);
+
+public:
+    Listener() : buttons_(BUTTON_QUEUE_SIZE, std::make_pair(Button(-1, 0), 0)) {}
+
+    void listenForButtons(Button button);
+    void listenForAxes(Types::Vector<int> axes);
+    void listenForFrame(const std::string &payload);
+
+    // In-process entry points, for a joystick in the same process: nothing to parse
+    void setButton(const Button &button);
+    void setAxes(const int *axes, int count);
+
+    Button button();
+
+    // It copies the last axes into @values, which must hold AxesState::MAX_AXES elements
+    void axes(int *values);
+
+    bool isButtonUpdated();
+    bool isAxesUpdated();
+
+    // Blocks until a button is queued or @timeout is over. Returns true if a button is available.
+    bool waitForButton(std::chrono::milliseconds timeout);
+
+    // Blocks until the axes are updated or @timeout is over. Returns true if they were updated.
+    bool waitForAxes(std::chrono::milliseconds timeout);
+};
+
+inline void Listener::listenForButtons(Button button)
+{
+    setButton(button);
+}
+
+inline void Listener::setButton(const Button &button)
+{
+    std::lock_guard<std::mutex> lock(mutexBtn_);
+
+    pushButton(button, LatencyHistogram::now());
+}
+
+inline void Listener::pushButton(const Button &button, uint64_t time)
+{
+    if (buttonsCount_ == BUTTON_QUEUE_SIZE)
+    {
+        mqttLogger::getInstance().log(logger::WARNING, "Button queue full, button dropped.");
+        return;
+    }
+
+    buttons_[(buttonsHead_ + buttonsCount_++) % BUTTON_QUEUE_SIZE] = std::make_pair(button, time);
+    buttonsCv_.notify_one();
+}
+
+inline Button Listener::button()
+{
+    static LatencyHistogram &queueLatency = Diagnostics::histogram("commands.queue");
+
+    std::lock_guard<std::mutex> lock(mutexBtn_);
+
+    if (buttonsCount_ == 0)
+        return Button(-1, 0);
+
+    Button button = buttons_[buttonsHead_].first;
+    queueLatency.record(LatencyHistogram::now() - buttons_[buttonsHead_].second);
+
+    buttonsHead_ = (buttonsHead_ + 1) % BUTTON_QUEUE_SIZE;
+    buttonsCount_--;
+
+    return button;
+}
+
+inline bool Listener::isButtonUpdated()
+{
+    std::lock_guard<std::mutex> lock(mutexBtn_);
+
+    return buttonsCount_ > 0;
+}
+
+inline bool Listener::waitForButton(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(mutexBtn_);
+
+    return buttonsCv_.wait_for(lock, timeout, [this]() { return buttonsCount_ > 0; });
+}
+
+inline bool Listener::isAxesUpdated()
+{
+    return isAxesUpdated_;
+}
+
+inline bool Listener::waitForAxes(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(mutexAxes_);
+
+    return axesCv_.wait_for(lock, timeout, [this]() { return isAxesUpdated_.load(); });
+}
+
+inline void Listener::listenForAxes(Types::Vector<int> axes)
+{
+    if (axes.empty())
+        return;
+
+    setAxes(axes.data(), axes.size());
+}
+
+inline void Listener::setAxes(const int *axes, int count)
+{
+    std::lock_guard<std::mutex> lock(mutexAxes_);
+
+    numAxes_ = std::min(count, (int)AxesState::MAX_AXES);
+    std::copy(axes, axes + numAxes_, axes_);
+    std::fill(axes_ + numAxes_, axes_ + AxesState::MAX_AXES, 0);
+
+    isAxesUpdated_ = true;
+    axesCv_.notify_one();
+}
+
+inline void Listener::listenForFrame(const std::string &payload)
+{
+    JoystickFrame frame;
+
+    if (!JoystickFrame::decode(payload.data(), payload.size(), frame))
+    {
+        mqttLogger::getInstance().log(logger::WARNING, "Invalid joystick frame received.");
+        return;
+    }
+
+    if (hasFrame_ && (uint16_t)(frame.sequence - frame_.sequence) != 1)
+        mqttLogger::getInstance().log(logger::WARNING, "Joystick frames lost before sequence " + std::to_string(frame.sequence) + ".");
+
+    uint64_t changed = hasFrame_ ? frame.buttons ^ frame_.buttons : frame.buttons;
+    if (changed)
+    {
+        std::lock_guard<std::mutex> lock(mutexBtn_);
+        uint64_t now = LatencyHistogram::now();
+
+        for (int id = 0; changed; id++, changed >>= 1)
+            if (changed & 1)
+                pushButton(Button(id, frame.isPressed(id)), now);
+    }
+
+    bool isAxesChanged = !hasFrame_ || frame.numAxes != frame_.numAxes ||
+                         !std::equal(frame.axes, frame.axes + frame.numAxes, frame_.axes);
+    if (frame.numAxes > 0 && isAxesChanged)
+    {
+        int axes[JoystickFrame::MAX_AXES];
+        std::copy(frame.axes, frame.axes + frame.numAxes, axes);
+        setAxes(axes, frame.numAxes);
+    }
+
+    frame_ = frame;
+    hasFrame_ = true;
+}
+
+inline void Listener::axes(int *values)
+{
+    std::lock_guard<std::mutex> lock(mutexAxes_);
+
+    isAxesUpdated_ = false;
+    std::copy(axes_, axes_ + AxesState::MAX_AXES, values);
+}
+
+/**
+ * How the axes talker sends actuator values to the ROV.
+ * @TOPICS  : one message on each of Topics::AXES, SHOULDER_VELOCITY, WRIST_VELOCITY and HAND_VELOCITY which changed.
+ * @BATCHED : a single @ControlFrame on @CONTROL_FRAME_TOPIC with all of them.
+ */
+enum class AxesFormat
+{
+    TOPICS,
+    BATCHED
+};
+
+/**
+ * Emergency stop, motor power and reset are @SAFETY commands, any other button is one of the @COMMANDS.
+ */
+inline Priority priorityOf(const ButtonAction &command)
+{
+    using namespace Politocean::Constants;
+    using namespace Politocean::Constants::Commands;
+
+    if (command.topic == Topics::COMMANDS &&
+        (command.action == Actions::ATMega::START_AND_STOP || command.action == Actions::ON ||
+         command.action == Actions::OFF || command.action == Actions::RESET))
+        return Priority::SAFETY;
+
+    return Priority::COMMANDS;
+}
+
+/**************************************************************
+ * Talker class for Joystick publisher
+ *************************************************************/
+
+class Talker
+{
+    /**
+     * @axesTalker_      : talker thread for axes values
+     * @buttonTalker_    : talker thread for button value
+     */
+    std::thread *axesTalker_ = nullptr, *buttonTalker_ = nullptr;
+
+    /**
+     * @isTalking_ : it is true if the talker is talking
+     */
+    std::atomic<bool> isTalking_{false};
+
+    /**
+     * @buttonMap_ : commands bound to each joystick button
+     */
+    ButtonMap buttonMap_;
+
+    AxesFormat axesFormat_ = AxesFormat::TOPICS;
+
+    /**
+     * @quantizer_ runs on the axes talker only.
+     * @suppressed_ counts the axes messages it saved, i.e. the ones full resolution axes would have sent on top.
+     */
+    AxisQuantizer quantizer_;
+    std::atomic<unsigned long> suppressed_{0};
+
+    /**
+     * @scheduler_ is the only one publishing: both talker threads queue their messages into it,
+     * button commands by their priorityOf(), actuator values as @AXES.
+     */
+    PublishScheduler scheduler_;
+
+public:
+    // It throws a @ButtonMapException if @path is not a valid button map
+    void loadButtonMap(const std::string &path);
+
+    // They take effect from the next startTalking()
+    void setAxesFormat(AxesFormat axesFormat);
+    void setQuantization(const Quantization &quantization);
+    void setQuantization(int axis, const Quantization &quantization);
+
+    unsigned long getSuppressed();
+
+    // Returns the number of axes updates dropped because a newer one came before they were sent
+    unsigned long getStale();
+
+    /**
+     * @publisher is any client exposing publish(topic, std::string) and is_connected(), e.g. @MqttClient.
+     * Talking stops when stopTalking() is called or the publisher disconnects.
+     */
+    template <class Publisher>
+    void startTalking(Publisher &publisher, Listener &listener);
+    void stopTalking();
+
+    bool isTalking();
+};
+
+template <class Publisher>
+void Talker::startTalking(Publisher &publisher, Listener &listener)
+{
+    using namespace Politocean::Constants;
+    using namespace Politocean::Constants::Commands;
+
+    if (isTalking_)
+        return;
+
+    isTalking_ = true;
+
+    scheduler_.start(publisher);
+
+    axesTalker_ = new std::thread([&]() {
+        static LatencyHistogram &axesLatency = Diagnostics::histogram("commands.axes");
+        static std::atomic<unsigned long> &suppressedCounter = Diagnostics::counter("commands.suppressed");
+
+        const uint32_t ATMEGA_AXES = AxesState::mask(Axes::X) | AxesState::mask(Axes::Y) | AxesState::mask(Axes::RZ) | AxesState::mask(Axes::PITCH);
+
+        // Number of messages the @changed axes cost in the current format
+        auto messages = [&](uint32_t changed) {
+            if (axesFormat_ == AxesFormat::BATCHED)
+                return (changed & (ATMEGA_AXES | AxesState::mask(Axes::SHOULDER) | AxesState::mask(Axes::WRIST) | AxesState::mask(Axes::HAND))) ? 1 : 0;
+
+            return ((changed & ATMEGA_AXES) ? 1 : 0) +
+                   ((changed & AxesState::mask(Axes::SHOULDER)) ? 1 : 0) +
+                   ((changed & AxesState::mask(Axes::WRIST)) ? 1 : 0) +
+                   ((changed & AxesState::mask(Axes::HAND)) ? 1 : 0);
+        };
+
+        // @raw keeps the full resolution axes, only to count what quantization saves
+        AxesState raw, state;
+        ControlFrame frame;
+
+        // Payloads are rebuilt in place, the steady-state loop does not allocate
+        std::string atmega, shoulder, wrist, hand, control;
+        for (std::string *payload : {&atmega, &shoulder, &wrist, &hand, &control})
+            payload->reserve(64);
+
+        while (isTalking_ && publisher.is_connected())
+        {
+            // An update wakes the talker up at once, the timeout only bounds how late it notices a stop
+            if (!listener.waitForAxes(std::chrono::milliseconds(Timing::Milliseconds::COMMANDS)))
+                continue;
+
+            LatencyHistogram::Timer timer(axesLatency);
+
+            listener.axes(raw.values);
+            std::copy(raw.values, raw.values + AxesState::MAX_AXES, state.values);
+            quantizer_.apply(state.values);
+
+            uint32_t changed = state.update();
+            const int *axes = state.values;
+
+            int saved = messages(raw.update()) - messages(changed);
+            if (saved > 0)
+            {
+                suppressed_ += saved;
+                suppressedCounter += saved;
+            }
+
+            if (axesFormat_ == AxesFormat::BATCHED)
+            {
+                frame.fields = 0;
+
+                if (changed & ATMEGA_AXES)
+                {
+                    frame.axes[0] = axes[Axes::X];
+                    frame.axes[1] = axes[Axes::Y];
+                    frame.axes[2] = axes[Axes::RZ];
+                    frame.axes[3] = axes[Axes::PITCH];
+                    frame.fields |= ControlFrame::AXES;
+                }
+                if (changed & AxesState::mask(Axes::SHOULDER))
+                {
+                    frame.shoulder = axes[Axes::SHOULDER];
+                    frame.fields |= ControlFrame::SHOULDER;
+                }
+                if (changed & AxesState::mask(Axes::WRIST))
+                {
+                    frame.wrist = axes[Axes::WRIST];
+                    frame.fields |= ControlFrame::WRIST;
+                }
+                if (changed & AxesState::mask(Axes::HAND))
+                {
+                    frame.hand = axes[Axes::HAND];
+                    frame.fields |= ControlFrame::HAND;
+                }
+
+                if (frame.fields)
+                {
+                    frame.sequence++;
+                    frame.toJson(control);
+                    scheduler_.push(Priority::AXES, CONTROL_FRAME_TOPIC, control);
+                }
+
+                continue;
+            }
+
+            if (changed & ATMEGA_AXES)
+            {
+                int atmega_axes[] = {axes[Axes::X], axes[Axes::Y], axes[Axes::RZ], axes[Axes::PITCH]};
+
+                toJson(atmega, atmega_axes, 4);
+                scheduler_.push(Priority::AXES, Topics::AXES, atmega);
+            }
+
+            if (changed & AxesState::mask(Axes::SHOULDER))
+            {
+                toJson(shoulder, axes[Axes::SHOULDER]);
+                scheduler_.push(Priority::AXES, Topics::SHOULDER_VELOCITY, shoulder);
+            }
+
+            if (changed & AxesState::mask(Axes::WRIST))
+            {
+                toJson(wrist, axes[Axes::WRIST]);
+                scheduler_.push(Priority::AXES, Topics::WRIST_VELOCITY, wrist);
+            }
+
+            if (changed & AxesState::mask(Axes::HAND))
+            {
+                toJson(hand, axes[Axes::HAND]);
+                scheduler_.push(Priority::AXES, Topics::HAND_VELOCITY, hand);
+            }
+        }
+    });
+
+    buttonTalker_ = new std::thread([&]() {
+        static LatencyHistogram &dispatchLatency = Diagnostics::histogram("commands.dispatch");
+
+        while (isTalking_ && publisher.is_connected())
+        {
+            // A button wakes the talker up at once, the timeout only bounds how late it notices a stop
+            if (!listener.waitForButton(std::chrono::milliseconds(Timing::Milliseconds::COMMANDS)))
+                continue;
+
+            LatencyHistogram::Timer timer(dispatchLatency);
+
+            Button button = listener.button();
+
+            // Topic and action are looked up in the table built at startup
+            const ButtonAction *command = buttonMap_.resolve(button.getId(), button.getValue());
+
+            if (command != nullptr)
+                scheduler_.push(priorityOf(*command), command->topic, command->action);
+        }
+
+        isTalking_ = false;
+    });
+}
+
+inline void Talker::loadButtonMap(const std::string &path)
+{
+    buttonMap_.load(path);
+}
+
+inline void Talker::setAxesFormat(AxesFormat axesFormat)
+{
+    axesFormat_ = axesFormat;
+}
+
+inline void Talker::setQuantization(const Quantization &quantization)
+{
+    quantizer_.set(quantization);
+}
+
+inline void Talker::setQuantization(int axis, const Quantization &quantization)
+{
+    quantizer_.set(axis, quantization);
+}
+
+inline unsigned long Talker::getSuppressed()
+{
+    return suppressed_;
+}
+
+inline unsigned long Talker::getStale()
+{
+    return scheduler_.getStale();
+}
+
+inline void Talker::stopTalking()
+{
+    if (axesTalker_ == nullptr)
+        return;
+
+    isTalking_ = false;
+
+    axesTalker_->join();
+    buttonTalker_->join();
+
+    delete axesTalker_;
+    delete buttonTalker_;
+    axesTalker_ = buttonTalker_ = nullptr;
+
+    // What the talkers queued last, e.g. a stop, still goes out
+    scheduler_.stop();
+}
+
+inline bool Talker::isTalking()
+{
+    return isTalking_;
+}
+
+} // namespace CommandParser
+} // namespace Politocean
+
+#endif //COMMAND_PARSER_H
@@ -0,0 +1,121 @@
+#ifndef CONTROL_FRAME_H
+#define CONTROL_FRAME_H
+
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+#include <json.hpp>
+
+namespace Politocean
+{
+
+/**
+ * Every actuator value changed by one axes update, in a single message instead of one
+ * on each of Topics::AXES, SHOULDER_VELOCITY, WRIST_VELOCITY and HAND_VELOCITY.
+ * It is published on @CONTROL_FRAME_TOPIC as JSON, with only the changed fields present:
+ *
+ *  {"seq":12,"axes":[x,y,rz,pitch],"shoulder":v,"wrist":v,"hand":v}
+ *
+ * @seq grows by one per frame, so that the ROV can tell lost frames and apply each one as a whole.
+ */
+struct ControlFrame
+{
+    enum Field : uint32_t
+    {
+        AXES = 1 << 0,
+        SHOULDER = 1 << 1,
+        WRIST = 1 << 2,
+        HAND = 1 << 3
+    };
+
+    static const int NUM_AXES = 4;
+
+    uint32_t sequence = 0;
+    uint32_t fields = 0;
+
+    int axes[NUM_AXES] = {0};
+    int shoulder = 0, wrist = 0, hand = 0;
+
+    bool has(Field field) const
+    {
+        return fields & field;
+    }
+
+    // Writes the frame into @payload, which keeps its capacity: once warm it does not allocate
+    void toJson(std::string &payload) const
+    {
+        char field[64];
+        int length;
+
+        length = snprintf(field, sizeof(field), "{\"seq\":%u", sequence);
+        payload.assign(field, length);
+
+        if (has(AXES))
+        {
+            length = snprintf(field, sizeof(field), ",\"axes\":[%d,%d,%d,%d]", axes[0], axes[1], axes[2], axes[3]);
+            payload.append(field, length);
+        }
+
+        auto append = [&](Field flag, const char *name, int value) {
+            if (!has(flag))
+                return;
+
+            length = snprintf(field, sizeof(field), ",\"%s\":%d", name, value);
+            payload.append(field, length);
+        };
+
+        append(SHOULDER, "shoulder", shoulder);
+        append(WRIST, "wrist", wrist);
+        append(HAND, "hand", hand);
+
+        payload.push_back('}');
+    }
+
+    // Reads a frame back, as the ROV does. Returns false if @payload is not a control frame.
+    static bool parse(const std::string &payload, ControlFrame &frame)
+    {
+        try
+        {
+            auto j_map = nlohmann::json::parse(payload);
+
+            frame = ControlFrame();
+            frame.sequence = j_map.at("seq");
+
+            if (j_map.count("axes"))
+            {
+                auto axes = j_map["axes"];
+                if (axes.size() != NUM_AXES)
+                    return false;
+
+                for (int i = 0; i < NUM_AXES; i++)
+                    frame.axes[i] = axes[i];
+                frame.fields |= AXES;
+            }
+
+            auto read = [&](Field flag, const char *name, int &value) {
+                if (!j_map.count(name))
+                    return;
+
+                value = j_map[name];
+                frame.fields |= flag;
+            };
+
+            read(SHOULDER, "shoulder", frame.shoulder);
+            read(WRIST, "wrist", frame.wrist);
+            read(HAND, "hand", frame.hand);
+        }
+        catch (...)
+        {
+            return false;
+        }
+
+        return true;
+    }
+};
+
+const std::string CONTROL_FRAME_TOPIC = "CommandParser/control/";
+
+} // namespace Politocean
+
+#endif //CONTROL_FRAME_H
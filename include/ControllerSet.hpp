@@ -0,0 +1,161 @@
+#ifndef CONTROLLER_SET_H
+#define CONTROLLER_SET_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <functional>
+
+#include "Joystick.h"
+#include "JoystickRecorder.h"
+
+#include "JoystickPublisher.hpp"
+#include "DevicePublisher.hpp"
+
+namespace Politocean
+{
+namespace JoystickPublisher
+{
+
+/**
+ * Listeners and talkers of the controllers attached by a JoystickManager, one per device.
+ * The pilot publishes on the usual topics, any other controller on topics of its own (see @DevicePublisher).
+ * The first controller attached while there is no pilot becomes the pilot; when the pilot is unplugged,
+ * a controller still attached takes its place, so that the ROV topics are never left silent.
+ *
+ * attach() and detach() are meant for JoystickManager::onAttach() and onDetach(): they run on the manager thread only.
+ * @Publisher is any client exposing publish(topic, const std::string &) and is_connected(), e.g. @MqttClient
+ */
+template <class Publisher>
+class ControllerSet
+{
+public:
+    // Called with the device of the new pilot, or an empty string if there is none left
+    typedef std::function<void(const std::string &device)> pilot_handler_t;
+
+private:
+    struct Controller
+    {
+        Joystick &joystick;
+        Listener listener;
+        Talker talker;
+        DevicePublisher<Publisher> publisher;
+
+        Controller(Joystick &joystick, Publisher &client, const std::string &device)
+            : joystick(joystick), listener(joystick), publisher(client, device) {}
+    };
+
+    Publisher &publisher_;
+    WireFormat wireFormat_ = WireFormat::JSON;
+
+    // @recorder_, if set, logs the raw events of whichever controller is the pilot
+    JoystickRecorder *recorder_ = nullptr;
+
+    std::map<std::string, std::unique_ptr<Controller>> controllers_;
+    std::string pilot_;
+
+    pilot_handler_t onPilot_;
+
+    // Topics of a controller which is not the pilot, e.g. "js1" for /dev/input/js1
+    static std::string deviceName(const std::string &device)
+    {
+        return device.substr(device.rfind('/') + 1);
+    }
+
+    void setPilot(Controller &controller)
+    {
+        pilot_ = controller.joystick.getDevice();
+
+        if (recorder_ != nullptr)
+            controller.joystick.setRecorder(recorder_);
+
+        if (onPilot_)
+            onPilot_(pilot_);
+    }
+
+public:
+    ControllerSet(Publisher &publisher) : publisher_(publisher) {}
+
+    ~ControllerSet()
+    {
+        for (auto &controller : controllers_)
+            controller.second->talker.stopTalking();
+    }
+
+    // They must be called before the first attach()
+    void setWireFormat(WireFormat wireFormat)
+    {
+        wireFormat_ = wireFormat;
+    }
+
+    void setRecorder(JoystickRecorder *recorder)
+    {
+        recorder_ = recorder;
+    }
+
+    void onPilot(pilot_handler_t handler)
+    {
+        onPilot_ = handler;
+    }
+
+    // Starts reading @joystick and publishing its updates
+    void attach(Joystick &joystick)
+    {
+        std::string device = joystick.getDevice();
+        bool isPilot = pilot_.empty();
+
+        std::unique_ptr<Controller> controller(new Controller(joystick, publisher_, isPilot ? "" : deviceName(device)));
+
+        controller->talker.setWireFormat(wireFormat_);
+        joystick.startReading(&Listener::listen, &controller->listener);
+        controller->talker.startTalking(controller->publisher, controller->listener);
+
+        if (isPilot)
+            setPilot(*controller);
+
+        controllers_[device] = std::move(controller);
+    }
+
+    /**
+     * Stops publishing the updates of @joystick, which is not reading anymore.
+     * If it was the pilot, another controller still attached, if any, is moved onto the pilot topics.
+     */
+    void detach(Joystick &joystick)
+    {
+        std::string device = joystick.getDevice();
+
+        auto controller = controllers_.find(device);
+        if (controller == controllers_.end())
+            return;
+
+        controller->second->talker.stopTalking();
+        controllers_.erase(controller);
+
+        if (device != pilot_)
+            return;
+
+        joystick.setRecorder(nullptr);
+        pilot_.clear();
+
+        if (controllers_.empty())
+        {
+            if (onPilot_)
+                onPilot_(pilot_);
+            return;
+        }
+
+        // The talker is restarted on the pilot topics: it reads on, from the same listener
+        Controller &successor = *controllers_.begin()->second;
+
+        successor.talker.stopTalking();
+        successor.publisher.setDevice("");
+        successor.talker.startTalking(successor.publisher, successor.listener);
+
+        setPilot(successor);
+    }
+};
+
+} // namespace JoystickPublisher
+} // namespace Politocean
+
+#endif //CONTROLLER_SET_H
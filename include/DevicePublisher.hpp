@@ -0,0 +1,74 @@
+#ifndef DEVICE_PUBLISHER_H
+#define DEVICE_PUBLISHER_H
+
+#include <string>
+
+#include "PolitoceanConstants.h"
+
+#include "JoystickFrame.hpp"
+
+namespace Politocean
+{
+namespace JoystickPublisher
+{
+
+/**
+ * Publisher for the talkers of one of several controllers: it publishes on the usual joystick topics
+ * followed by @device, e.g. the axes of /dev/input/js1 on Topics::JOYSTICK_AXES + "js1/".
+ * With an empty @device it publishes on the usual topics, as the pilot joystick does.
+ * Joystick topics are built once, so publishing does not allocate.
+ *
+ * @Publisher is any client exposing publish(topic, const std::string &) and is_connected(), e.g. @MqttClient
+ */
+template <class Publisher>
+class DevicePublisher
+{
+    Publisher &publisher_;
+    std::string suffix_;
+
+    std::string axesTopic_, buttonsTopic_, frameTopic_;
+
+public:
+    DevicePublisher(Publisher &publisher, const std::string &device) : publisher_(publisher)
+    {
+        setDevice(device);
+    }
+
+    // Moves onto the topics of @device, e.g. onto the usual ones when a controller becomes the pilot
+    void setDevice(const std::string &device)
+    {
+        using namespace Politocean::Constants;
+
+        suffix_ = device.empty() ? "" : device + "/";
+
+        axesTopic_ = Topics::JOYSTICK_AXES + suffix_;
+        buttonsTopic_ = Topics::JOYSTICK_BUTTONS + suffix_;
+        frameTopic_ = JOYSTICK_FRAME_TOPIC + suffix_;
+    }
+
+    void publish(const std::string &topic, const std::string &payload)
+    {
+        using namespace Politocean::Constants;
+
+        if (suffix_.empty())
+            publisher_.publish(topic, payload);
+        else if (topic == Topics::JOYSTICK_AXES)
+            publisher_.publish(axesTopic_, payload);
+        else if (topic == Topics::JOYSTICK_BUTTONS)
+            publisher_.publish(buttonsTopic_, payload);
+        else if (topic == JOYSTICK_FRAME_TOPIC)
+            publisher_.publish(frameTopic_, payload);
+        else
+            publisher_.publish(topic + suffix_, payload);
+    }
+
+    bool is_connected()
+    {
+        return publisher_.is_connected();
+    }
+};
+
+} // namespace JoystickPublisher
+} // namespace Politocean
+
+#endif //DEVICE_PUBLISHER_H
@@ -0,0 +1,172 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+
+#include "json.hpp"
+
+#include "LatencyHistogram.hpp"
+
+namespace Politocean
+{
+
+const std::string DIAGNOSTICS_TOPIC = "Diagnostics/latency/";
+
+/**
+ * Registry of the latency histograms and event counters of a process, and the thread which publishes them.
+ * Every @period milliseconds a JSON report is sent on @DIAGNOSTICS_TOPIC:
+ *  {
+ *      "source": "PolitoceanJoystick",
+ *      "period": 1000,
+ *      "histograms": {
+ *          "joystick.read": { "count": 120, "p50": 3.1, "p99": 12.4, "max": 20.8 },
+ *          ...
+ *      },
+ *      "counters": {
+ *          "commands.suppressed": 87,
+ *          ...
+ *      }
+ *  }
+ * Durations are in microseconds, counts and counters refer to the last period only.
+ */
+class Diagnostics
+{
+public:
+    static const int DFLT_PERIOD = 1000;
+
+private:
+    std::thread *publisher_ = nullptr;
+    std::atomic<bool> isPublishing_{false};
+
+    // @cv_ lets stopPublishing() interrupt the wait between two reports
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    static std::mutex &registryMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::map<std::string, LatencyHistogram> &registry()
+    {
+        static std::map<std::string, LatencyHistogram> histograms;
+        return histograms;
+    }
+
+    static std::map<std::string, std::atomic<unsigned long>> &counters()
+    {
+        static std::map<std::string, std::atomic<unsigned long>> counters;
+        return counters;
+    }
+
+public:
+    /**
+     * Returns the histogram called @name, created on first use. It lives as long as the process,
+     * so call sites look it up once and keep the reference:
+     *  static LatencyHistogram &latency = Diagnostics::histogram("joystick.read");
+     */
+    static LatencyHistogram &histogram(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+
+        return registry()[name];
+    }
+
+    // Returns the counter called @name, created at 0 on first use. Like histograms, it is looked up once.
+    static std::atomic<unsigned long> &counter(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+
+        return counters()[name];
+    }
+
+    // Summarizes every histogram and counter and starts a new period
+    static std::string report(const std::string &source, int period)
+    {
+        nlohmann::json j_report;
+        j_report["source"] = source;
+        j_report["period"] = period;
+        j_report["histograms"] = nlohmann::json::object();
+        j_report["counters"] = nlohmann::json::object();
+
+        std::lock_guard<std::mutex> lock(registryMutex());
+
+        for (auto &entry : registry())
+        {
+            LatencyHistogram::Summary summary = entry.second.summary();
+
+            nlohmann::json &j_histogram = j_report["histograms"][entry.first];
+            j_histogram["count"] = summary.count;
+            j_histogram["p50"] = summary.p50 / 1000.0;
+            j_histogram["p99"] = summary.p99 / 1000.0;
+            j_histogram["max"] = summary.max / 1000.0;
+        }
+
+        for (auto &entry : counters())
+            j_report["counters"][entry.first] = entry.second.exchange(0);
+
+        return j_report.dump();
+    }
+
+    ~Diagnostics()
+    {
+        stopPublishing();
+    }
+
+    /**
+     * Publishes a report every @period milliseconds, with @source telling which process it comes from.
+     * @publisher is any client exposing publish(topic, std::string), e.g. @MqttClient
+     */
+    template <class Publisher>
+    void startPublishing(Publisher &publisher, const std::string &source, int period = DFLT_PERIOD)
+    {
+        if (isPublishing_)
+            return;
+
+        isPublishing_ = true;
+
+        publisher_ = new std::thread([this, &publisher, source, period]() {
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            while (isPublishing_)
+            {
+                if (cv_.wait_for(lock, std::chrono::milliseconds(period), [this]() { return !isPublishing_; }))
+                    break;
+
+                publisher.publish(DIAGNOSTICS_TOPIC, report(source, period));
+            }
+        });
+    }
+
+    void stopPublishing()
+    {
+        if (!isPublishing_)
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            isPublishing_ = false;
+        }
+        cv_.notify_all();
+
+        publisher_->join();
+        delete publisher_;
+        publisher_ = nullptr;
+    }
+
+    bool isPublishing()
+    {
+        return isPublishing_;
+    }
+};
+
+} // namespace Politocean
+
+#endif //DIAGNOSTICS_H
@@ -0,0 +1,211 @@
+#ifndef JOYSTICK_FRAME_H
+#define JOYSTICK_FRAME_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Politocean
+{
+
+/**
+ * Compact binary alternative to the JSON axes and buttons messages.
+ * It is published on @JOYSTICK_FRAME_TOPIC, base64 encoded, with the following little endian layout:
+ *
+ *  0      header   (HEADER)
+ *  1      number of axes, up to MAX_AXES
+ *  2..3   sequence number
+ *  4..11  timestamp of the last joystick event, in microseconds
+ *  12..19 buttons bitfield, bit i is set if button i is pressed
+ *  20..   axes, as int16
+ *
+ * The raw layout is full of NUL bytes, while MQTT clients pass payloads around as strings:
+ * base64 keeps the frame printable, whatever the client does with it.
+ * Encoding and decoding never allocate.
+ */
+class JoystickFrame
+{
+    static void put(char *buffer, uint64_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; i++)
+            buffer[i] = (value >> (8 * i)) & 0xFF;
+    }
+
+    static uint64_t get(const char *buffer, int bytes)
+    {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; i++)
+            value |= (uint64_t)(unsigned char)buffer[i] << (8 * i);
+        return value;
+    }
+
+    static const char *alphabet()
+    {
+        return "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    }
+
+    // Returns the 6 bits @c stands for, or -1 if it is not a base64 digit
+    static int digit(char c)
+    {
+        if (c >= 'A' && c <= 'Z')
+            return c - 'A';
+        if (c >= 'a' && c <= 'z')
+            return c - 'a' + 26;
+        if (c >= '0' && c <= '9')
+            return c - '0' + 52;
+        if (c == '+')
+            return 62;
+        if (c == '/')
+            return 63;
+        return -1;
+    }
+
+    static std::size_t encodedSize(std::size_t rawSize)
+    {
+        return 4 * ((rawSize + 2) / 3);
+    }
+
+public:
+    static const unsigned char HEADER = 0xB1;
+    static const std::size_t MAX_AXES = 16;
+    static const std::size_t HEADER_SIZE = 20;
+    static const std::size_t MAX_RAW_SIZE = HEADER_SIZE + 2 * MAX_AXES;
+
+    // Size of the largest encoded frame
+    static const std::size_t MAX_SIZE = 4 * ((MAX_RAW_SIZE + 2) / 3);
+
+    // Encoded frames start with the base64 digit of HEADER, which no JSON payload starts with
+    static const char ENCODED_HEADER = 's';
+
+    uint16_t sequence = 0;
+    uint64_t timestamp = 0;
+    uint64_t buttons = 0;
+    uint8_t numAxes = 0;
+    int16_t axes[MAX_AXES] = {0};
+
+    void setAxes(const std::vector<int> &values)
+    {
+        numAxes = values.size() < MAX_AXES ? values.size() : MAX_AXES;
+        for (std::size_t i = 0; i < numAxes; i++)
+            axes[i] = values[i] < -32767 ? -32767 : values[i] > 32767 ? 32767 : values[i];
+    }
+
+    void setButton(int id, bool pressed)
+    {
+        if (id < 0 || id >= 64)
+            return;
+
+        if (pressed)
+            buttons |= 1ULL << id;
+        else
+            buttons &= ~(1ULL << id);
+    }
+
+    bool isPressed(int id) const
+    {
+        return id >= 0 && id < 64 && ((buttons >> id) & 1);
+    }
+
+    // Size of the encoded frame
+    std::size_t size() const
+    {
+        return encodedSize(HEADER_SIZE + 2 * numAxes);
+    }
+
+    /**
+     * Writes the encoded frame into @buffer, which must hold at least @MAX_SIZE bytes.
+     * Returns the number of bytes written.
+     */
+    std::size_t encode(char *buffer) const
+    {
+        char raw[MAX_RAW_SIZE];
+        std::size_t rawSize = HEADER_SIZE + 2 * numAxes;
+
+        raw[0] = (char)HEADER;
+        raw[1] = numAxes;
+        put(raw + 2, sequence, 2);
+        put(raw + 4, timestamp, 8);
+        put(raw + 12, buttons, 8);
+        for (std::size_t i = 0; i < numAxes; i++)
+            put(raw + HEADER_SIZE + 2 * i, (uint16_t)axes[i], 2);
+
+        char *out = buffer;
+        for (std::size_t i = 0; i < rawSize; i += 3)
+        {
+            std::size_t count = rawSize - i < 3 ? rawSize - i : 3;
+            uint32_t group = 0;
+            for (std::size_t j = 0; j < count; j++)
+                group |= (uint32_t)(unsigned char)raw[i + j] << (16 - 8 * j);
+
+            for (std::size_t j = 0; j < 4; j++)
+                *out++ = j <= count ? alphabet()[(group >> (18 - 6 * j)) & 0x3F] : '=';
+        }
+
+        return out - buffer;
+    }
+
+    /**
+     * Reads a frame from @size bytes of encoded @data.
+     * Returns false if @data is not a valid frame, e.g. a JSON payload.
+     */
+    static bool decode(const char *data, std::size_t size, JoystickFrame &frame)
+    {
+        if (size < encodedSize(HEADER_SIZE) || size > MAX_SIZE || size % 4 != 0)
+            return false;
+
+        char raw[MAX_RAW_SIZE + 2];
+        std::size_t rawSize = 0;
+
+        for (std::size_t i = 0; i < size; i += 4)
+        {
+            uint32_t group = 0;
+            std::size_t count = 3;
+
+            for (std::size_t j = 0; j < 4; j++)
+            {
+                int bits = digit(data[i + j]);
+
+                // Padding is only allowed as the last one or two digits
+                if (bits < 0)
+                {
+                    if (data[i + j] != '=' || i + 4 != size || j < 2 || (j == 2 && data[i + 3] != '='))
+                        return false;
+                    count = count < j - 1 ? count : j - 1;
+                    bits = 0;
+                }
+                group |= (uint32_t)bits << (18 - 6 * j);
+            }
+
+            for (std::size_t j = 0; j < count; j++)
+                raw[rawSize++] = (group >> (16 - 8 * j)) & 0xFF;
+        }
+
+        if (rawSize < HEADER_SIZE || (unsigned char)raw[0] != HEADER)
+            return false;
+
+        std::size_t numAxes = (unsigned char)raw[1];
+        if (numAxes > MAX_AXES || rawSize != HEADER_SIZE + 2 * numAxes)
+            return false;
+
+        frame.numAxes = numAxes;
+        frame.sequence = get(raw + 2, 2);
+        frame.timestamp = get(raw + 4, 8);
+        frame.buttons = get(raw + 12, 8);
+        for (std::size_t i = 0; i < numAxes; i++)
+            frame.axes[i] = (int16_t)get(raw + HEADER_SIZE + 2 * i, 2);
+
+        return true;
+    }
+
+    static bool isFrame(const std::string &payload)
+    {
+        return !payload.empty() && payload[0] == ENCODED_HEADER;
+    }
+};
+
+const std::string JOYSTICK_FRAME_TOPIC = "JoystickPublisher/frame/";
+
+} // namespace Politocean
+
+#endif //JOYSTICK_FRAME_H
@@ -0,0 +1,473 @@
+#ifndef JOYSTICK_PUBLISHER_H
+#define JOYSTICK_PUBLISHER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdlib>
+
+#include "Joystick.h"
+#include "TripleBuffer.h"
+
+#include "PolitoceanConstants.h"
+
+#include "Button.hpp"
+#include "JoystickFrame.hpp"
+#include "Diagnostics.hpp"
+#include "JsonPayload.hpp"
+
+namespace Politocean
+{
+namespace JoystickPublisher
+{
+
+/**************************************************************
+ * Listener class for Joystick device
+ *************************************************************/
+
+class Listener
+{
+    Joystick &joystick_;
+
+    /**
+     * @axes_ hands the axes over from the joystick thread to the axes talker without locking:
+     * the talker always reads a complete vector, never a torn one.
+     */
+    TripleBuffer<std::vector<int>> axes_;
+
+    /**
+     * @buttonCv_ wakes the button talker up when the joystick queues a transition,
+     * @axesCv_ wakes the axes talker up when new axes are written.
+     * @mutex_ only guards the waits, the data themselves are handed over lock-free.
+     */
+    std::mutex mutex_;
+    std::condition_variable buttonCv_, axesCv_;
+
+public:
+    // Reads of @joystick are timed in the "joystick.read" histogram
+    Listener(Joystick &joystick) : joystick_(joystick)
+    {
+        static LatencyHistogram &readLatency = Diagnostics::histogram("joystick.read");
+
+        joystick_.onRead([](uint64_t duration) { readLatency.record(duration); });
+    }
+
+    // Buttons are taken from the joystick queue of transitions, the last button it passes is of no use here
+    void listen(const std::vector<int> &axes, unsigned char);
+
+    /**
+     * The latest axes, without copying them. Only the axes talker reads them:
+     * the reference stays valid until its next call.
+     */
+    const std::vector<int> &axes();
+    uint64_t lastEventTime();
+    bool button(ButtonEvent &event);
+    bool isButtonUpdated();
+
+    /**
+     * Blocks until a button transition is available and pops it into @event.
+     * Returns false, without popping, as soon as @isWaiting turns false and wakeUp() is called.
+     */
+    bool waitForButton(ButtonEvent &event, const std::atomic<bool> &isWaiting);
+
+    /**
+     * Blocks until new axes are written, @deadline is reached or @isWaiting turns false.
+     * Returns true if new axes are available.
+     */
+    bool waitForAxes(std::chrono::steady_clock::time_point deadline, const std::atomic<bool> &isWaiting);
+    void wakeUp();
+};
+
+inline void Listener::listen(const std::vector<int> &axes, unsigned char)
+{
+    static LatencyHistogram &listenLatency = Diagnostics::histogram("joystick.listen");
+    LatencyHistogram::Timer timer(listenLatency);
+
+    // Same size assignment: it does not allocate once the buffers are warm
+    axes_.write(axes);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    axesCv_.notify_one();
+    if (joystick_.isButtonUpdated())
+        buttonCv_.notify_one();
+}
+
+inline const std::vector<int> &Listener::axes()
+{
+    return axes_.read();
+}
+
+inline uint64_t Listener::lastEventTime()
+{
+    return joystick_.getLastEventTime();
+}
+
+// Button transitions are taken from the joystick queue, so none of them is lost between two callbacks.
+inline bool Listener::button(ButtonEvent &event)
+{
+    return joystick_.nextButton(event);
+}
+
+inline bool Listener::isButtonUpdated()
+{
+    return joystick_.isButtonUpdated();
+}
+
+inline bool Listener::waitForButton(ButtonEvent &event, const std::atomic<bool> &isWaiting)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    buttonCv_.wait(lock, [&]() { return !isWaiting || joystick_.isButtonUpdated(); });
+
+    if (!isWaiting)
+        return false;
+
+    return joystick_.nextButton(event);
+}
+
+inline bool Listener::waitForAxes(std::chrono::steady_clock::time_point deadline, const std::atomic<bool> &isWaiting)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    axesCv_.wait_until(lock, deadline, [&]() { return !isWaiting || axes_.isUpdated(); });
+
+    return isWaiting && axes_.isUpdated();
+}
+
+inline void Listener::wakeUp()
+{
+    // Taking the lock orders the notification after any waiter checked its condition
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    buttonCv_.notify_all();
+    axesCv_.notify_all();
+}
+
+/**
+ * How the axes talker publishes on @Topics::JOYSTICK_AXES.
+ * @PERIODIC    : every Timing::Milliseconds::COMMANDS, whether anything moved or not.
+ * @ON_CHANGE   : as soon as an axis moves by more than @epsilon, at most @maxRate times per second,
+ *                and anyway every @heartbeat milliseconds so that subscribers know the joystick is alive.
+ */
+struct AxesPublishing
+{
+    enum class Mode
+    {
+        PERIODIC,
+        ON_CHANGE
+    };
+
+    Mode mode;
+    int epsilon;
+    int maxRate;
+    int heartbeat;
+};
+
+const AxesPublishing DFLT_AXES_PUBLISHING = {AxesPublishing::Mode::ON_CHANGE, 0, 100, 1000};
+
+/**
+ * @JSON    : axes on @Topics::JOYSTICK_AXES and buttons on @Topics::JOYSTICK_BUTTONS.
+ * @BINARY  : a whole @JoystickFrame on @JOYSTICK_FRAME_TOPIC for every axes or button update.
+ */
+enum class WireFormat
+{
+    JSON,
+    BINARY
+};
+
+/**
+ * Hands @axes or @event over as they are if @Publisher takes them typed, e.g. @CommandParser::LocalBridge,
+ * through handOverAxes(axes, count) or handOverButton(id, value). Returns true if the update must still be
+ * serialized and published: always for a broker client, only while monitoring for a typed publisher.
+ */
+template <class Publisher>
+auto handOverAxes(Publisher &publisher, const std::vector<int> &axes, int)
+    -> decltype(publisher.handOverAxes(axes.data(), (int)axes.size()), bool())
+{
+    publisher.handOverAxes(axes.data(), (int)axes.size());
+    return publisher.isMonitoring();
+}
+
+template <class Publisher>
+bool handOverAxes(Publisher &, const std::vector<int> &, long)
+{
+    return true;
+}
+
+template <class Publisher>
+auto handOverButton(Publisher &publisher, const ButtonEvent &event, int)
+    -> decltype(publisher.handOverButton(event.id, event.value), bool())
+{
+    publisher.handOverButton(event.id, event.value);
+    return publisher.isMonitoring();
+}
+
+template <class Publisher>
+bool handOverButton(Publisher &, const ButtonEvent &, long)
+{
+    return true;
+}
+
+/**************************************************************
+ * Talker class for Joystick publisher
+ *************************************************************/
+
+class Talker
+{
+    static const std::size_t PAYLOAD_CAPACITY = 256;
+
+    /**
+	 * @axesTalker		: talker thread for axes values
+	 * @buttonTalker	: talker thread for button value
+	 */
+    std::thread *axesTalker_ = nullptr, *buttonTalker_ = nullptr;
+
+    Listener *listener_ = nullptr;
+
+    /**
+	 * @isTalking_ : it is true if the talker is talking
+	 */
+    std::atomic<bool> isTalking_{false};
+
+    AxesPublishing axesPublishing_ = DFLT_AXES_PUBLISHING;
+    WireFormat wireFormat_ = WireFormat::JSON;
+
+    /**
+     * @frame_ is the last state sent in binary format, shared by both talkers.
+     * @frameMutex_ makes frames leave in sequence order.
+     */
+    JoystickFrame frame_;
+    std::mutex frameMutex_;
+
+    /**
+     * Payloads are serialized in place into these buffers, reused for every message:
+     * @axesPayload_ belongs to the axes talker, @buttonPayload_ to the button talker
+     * and @framePayload_ is guarded by @frameMutex_.
+     */
+    std::string axesPayload_, buttonPayload_, framePayload_;
+
+    // The axes last published, kept by the axes talker to detect changes
+    std::vector<int> prevAxes_;
+
+    static bool isChanged(const std::vector<int> &axes, const std::vector<int> &prevAxes, int epsilon);
+
+    template <class Publisher>
+    void publishOnChange(Publisher &publisher, Listener &listener);
+
+    // It copies the axes it publishes into @published
+    template <class Publisher>
+    void publishAxes(Publisher &publisher, Listener &listener, std::vector<int> &published);
+    template <class Publisher>
+    void publishButton(Publisher &publisher, const ButtonEvent &event);
+    template <class Publisher>
+    void publishFrame(Publisher &publisher);
+
+public:
+    // They take effect from the next startTalking()
+    void setAxesPublishing(const AxesPublishing &axesPublishing);
+    void setWireFormat(WireFormat wireFormat);
+
+    /**
+     * @publisher is any client exposing publish(topic, const std::string &), e.g. @MqttClient,
+     * or a publisher taking typed updates, e.g. @CommandParser::LocalBridge.
+     * Every payload is handed over from the talker buffers: once they are warm, talking does not allocate.
+     */
+    template <class Publisher>
+    void startTalking(Publisher &publisher, Listener &listener);
+    void stopTalking();
+
+    bool isTalking();
+};
+
+template <class Publisher>
+void Talker::startTalking(Publisher &publisher, Listener &listener)
+{
+    using namespace Politocean::Constants;
+
+    if (isTalking_)
+        return;
+
+    isTalking_ = true;
+    listener_ = &listener;
+
+    axesPayload_.reserve(PAYLOAD_CAPACITY);
+    buttonPayload_.reserve(PAYLOAD_CAPACITY);
+    framePayload_.reserve(JoystickFrame::MAX_SIZE);
+
+    axesTalker_ = new std::thread([&]() {
+        if (axesPublishing_.mode == AxesPublishing::Mode::ON_CHANGE)
+        {
+            publishOnChange(publisher, listener);
+            return;
+        }
+
+        while (isTalking_)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(Timing::Milliseconds::COMMANDS));
+
+            publishAxes(publisher, listener, prevAxes_);
+        }
+    });
+
+    // It sleeps until the joystick thread queues a button transition
+    buttonTalker_ = new std::thread([&]() {
+        ButtonEvent event;
+
+        while (listener.waitForButton(event, isTalking_))
+            publishButton(publisher, event);
+    });
+}
+
+template <class Publisher>
+void Talker::publishAxes(Publisher &publisher, Listener &listener, std::vector<int> &published)
+{
+    using namespace Politocean::Constants;
+
+    static LatencyHistogram &publishLatency = Diagnostics::histogram("joystick.publish.axes");
+    LatencyHistogram::Timer timer(publishLatency);
+
+    const std::vector<int> &axes = listener.axes();
+
+    bool isSerialized = handOverAxes(publisher, axes, 0);
+
+    if (isSerialized && wireFormat_ == WireFormat::BINARY)
+    {
+        std::lock_guard<std::mutex> lock(frameMutex_);
+
+        frame_.setAxes(axes);
+        frame_.timestamp = listener.lastEventTime();
+        publishFrame(publisher);
+    }
+    else if (isSerialized)
+    {
+        toJson(axesPayload_, axes.data(), axes.size());
+        publisher.publish(Topics::JOYSTICK_AXES, axesPayload_);
+    }
+
+    // Same size assignment: it does not allocate once warm
+    published = axes;
+}
+
+template <class Publisher>
+void Talker::publishButton(Publisher &publisher, const ButtonEvent &event)
+{
+    using namespace Politocean::Constants;
+
+    static LatencyHistogram &publishLatency = Diagnostics::histogram("joystick.publish.button");
+    LatencyHistogram::Timer timer(publishLatency);
+
+    if (!handOverButton(publisher, event, 0))
+        return;
+
+    if (wireFormat_ == WireFormat::BINARY)
+    {
+        std::lock_guard<std::mutex> lock(frameMutex_);
+
+        frame_.setButton(event.id, event.value);
+        frame_.timestamp = event.time;
+        publishFrame(publisher);
+    }
+    else
+    {
+        buttonToJson(buttonPayload_, event.id, event.value);
+        publisher.publish(Topics::JOYSTICK_BUTTONS, buttonPayload_);
+    }
+}
+
+// @frameMutex_ must be held
+template <class Publisher>
+void Talker::publishFrame(Publisher &publisher)
+{
+    frame_.sequence++;
+
+    // Resizing within the reserved capacity does not allocate
+    framePayload_.resize(JoystickFrame::MAX_SIZE);
+    framePayload_.resize(frame_.encode(&framePayload_[0]));
+
+    publisher.publish(JOYSTICK_FRAME_TOPIC, framePayload_);
+}
+
+template <class Publisher>
+void Talker::publishOnChange(Publisher &publisher, Listener &listener)
+{
+    using std::chrono::steady_clock;
+
+    const steady_clock::duration minInterval = std::chrono::microseconds(1000000 / std::max(axesPublishing_.maxRate, 1));
+    const steady_clock::duration heartbeat = std::chrono::milliseconds(axesPublishing_.heartbeat);
+
+    publishAxes(publisher, listener, prevAxes_);
+    steady_clock::time_point lastPublish = steady_clock::now();
+
+    while (isTalking_)
+    {
+        bool isUpdated = listener.waitForAxes(lastPublish + heartbeat, isTalking_);
+
+        if (!isTalking_)
+            break;
+
+        if (isUpdated && isChanged(listener.axes(), prevAxes_, axesPublishing_.epsilon))
+        {
+            // Rate limit: wait out the interval, then send the latest axes rather than the first change
+            std::this_thread::sleep_until(lastPublish + minInterval);
+        }
+        else if (steady_clock::now() < lastPublish + heartbeat)
+            continue;
+
+        publishAxes(publisher, listener, prevAxes_);
+        lastPublish = steady_clock::now();
+    }
+}
+
+inline bool Talker::isChanged(const std::vector<int> &axes, const std::vector<int> &prevAxes, int epsilon)
+{
+    if (axes.size() != prevAxes.size())
+        return true;
+
+    for (std::size_t i = 0; i < axes.size(); i++)
+        if (std::abs(axes[i] - prevAxes[i]) > epsilon)
+            return true;
+
+    return false;
+}
+
+inline void Talker::setAxesPublishing(const AxesPublishing &axesPublishing)
+{
+    axesPublishing_ = axesPublishing;
+}
+
+inline void Talker::setWireFormat(WireFormat wireFormat)
+{
+    wireFormat_ = wireFormat;
+}
+
+inline void Talker::stopTalking()
+{
+    if (!isTalking_)
+        return;
+
+    isTalking_ = false;
+    listener_->wakeUp();
+
+    axesTalker_->join();
+    buttonTalker_->join();
+
+    delete axesTalker_;
+    delete buttonTalker_;
+    axesTalker_ = buttonTalker_ = nullptr;
+}
+
+inline bool Talker::isTalking()
+{
+    return isTalking_;
+}
+
+} // namespace JoystickPublisher
+} // namespace Politocean
+
+#endif //JOYSTICK_PUBLISHER_H
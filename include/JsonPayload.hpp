@@ -0,0 +1,50 @@
+#ifndef JSON_PAYLOAD_H
+#define JSON_PAYLOAD_H
+
+#include <string>
+#include <cstdio>
+
+namespace Politocean
+{
+
+/**
+ * Writers of the few JSON payloads on the control path, working on caller-owned buffers.
+ * A @payload keeps its capacity between calls, so once warm none of them allocates.
+ * They write exactly what Types::Vector<int> and Button stringify to.
+ */
+
+// Writes @count @values as a JSON array
+inline void toJson(std::string &payload, const int *values, int count)
+{
+    char number[16];
+
+    payload.assign(1, '[');
+    for (int i = 0; i < count; i++)
+    {
+        int length = snprintf(number, sizeof(number), i ? ",%d" : "%d", values[i]);
+        payload.append(number, length);
+    }
+    payload.push_back(']');
+}
+
+// Writes a single value as a JSON number
+inline void toJson(std::string &payload, int value)
+{
+    char number[16];
+
+    int length = snprintf(number, sizeof(number), "%d", value);
+    payload.assign(number, length);
+}
+
+// Writes a button as {"id":@id,"value":@value}
+inline void buttonToJson(std::string &payload, int id, int value)
+{
+    char button[48];
+
+    int length = snprintf(button, sizeof(button), "{\"id\":%d,\"value\":%d}", id, value);
+    payload.assign(button, length);
+}
+
+} // namespace Politocean
+
+#endif //JSON_PAYLOAD_H
@@ -0,0 +1,149 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace Politocean
+{
+
+/**
+ * HDR-style histogram of durations in nanoseconds.
+ * Each power of two is split in SUB_BUCKETS linear buckets, so any value is kept within 1/SUB_BUCKETS
+ * of its real size with a fixed, small table. Recording is a relaxed atomic increment: any number
+ * of threads can record while another one takes summaries, and none of them ever blocks.
+ */
+class LatencyHistogram
+{
+public:
+    static const int SUB_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+
+    // Values from 2^MAX_BITS ns (about 18 minutes) on are counted in the last bucket
+    static const int MAX_BITS = 40;
+    static const int NUM_BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+    // Durations in nanoseconds, @count is the number of values recorded
+    struct Summary
+    {
+        uint64_t count;
+        uint64_t p50, p99, max;
+    };
+
+    /**
+     * Records the time from its construction to its destruction:
+     *  { LatencyHistogram::Timer timer(histogram); ... }
+     */
+    class Timer
+    {
+        LatencyHistogram &histogram_;
+        uint64_t start_;
+
+    public:
+        Timer(LatencyHistogram &histogram) : histogram_(histogram), start_(now()) {}
+        ~Timer() { histogram_.record(now() - start_); }
+    };
+
+private:
+    std::atomic<uint64_t> buckets_[NUM_BUCKETS];
+    std::atomic<uint64_t> max_;
+
+    static int index(uint64_t value)
+    {
+        if (value < SUB_BUCKETS)
+            return value;
+
+        int msb = 63 - __builtin_clzll(value);
+        if (msb >= MAX_BITS)
+            return NUM_BUCKETS - 1;
+
+        int shift = msb - SUB_BITS;
+        return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    // The highest value counted in bucket @index
+    static uint64_t highest(int index)
+    {
+        if (index < SUB_BUCKETS)
+            return index;
+
+        int shift = index / SUB_BUCKETS - 1;
+        return ((uint64_t)(SUB_BUCKETS + index % SUB_BUCKETS + 1) << shift) - 1;
+    }
+
+public:
+    LatencyHistogram()
+    {
+        for (std::atomic<uint64_t> &bucket : buckets_)
+            bucket.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    // Monotonic time in nanoseconds
+    static uint64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void record(uint64_t value)
+    {
+        buckets_[index(value)].fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed))
+            ;
+    }
+
+    /**
+     * Summarizes the values recorded so far. With @reset, it starts a new interval:
+     * a value recorded meanwhile is counted either in this summary or in the next one.
+     * Percentiles are reported as the highest value of their bucket, never above @max.
+     */
+    Summary summary(bool reset = true)
+    {
+        uint64_t counts[NUM_BUCKETS];
+        Summary summary = {0, 0, 0, 0};
+
+        for (int i = 0; i < NUM_BUCKETS; i++)
+        {
+            counts[i] = reset ? buckets_[i].exchange(0, std::memory_order_relaxed) : buckets_[i].load(std::memory_order_relaxed);
+            summary.count += counts[i];
+        }
+        summary.max = reset ? max_.exchange(0, std::memory_order_relaxed) : max_.load(std::memory_order_relaxed);
+
+        if (summary.count == 0)
+            return summary;
+
+        uint64_t rank50 = (summary.count * 50 + 99) / 100, rank99 = (summary.count * 99 + 99) / 100;
+        uint64_t seen = 0;
+
+        for (int i = 0; i < NUM_BUCKETS && seen < rank99; i++)
+        {
+            if (counts[i] == 0)
+                continue;
+
+            if (seen < rank50 && seen + counts[i] >= rank50)
+                summary.p50 = highest(i);
+
+            seen += counts[i];
+
+            if (seen >= rank99)
+                summary.p99 = highest(i);
+        }
+
+        if (summary.p50 > summary.max)
+            summary.p50 = summary.max;
+        if (summary.p99 > summary.max)
+            summary.p99 = summary.max;
+
+        return summary;
+    }
+};
+
+} // namespace Politocean
+
+#endif //LATENCY_HISTOGRAM_H
@@ -0,0 +1,62 @@
+#ifndef LOCAL_BRIDGE_H
+#define LOCAL_BRIDGE_H
+
+#include <string>
+
+#include "Button.hpp"
+#include "CommandParser.hpp"
+
+namespace Politocean
+{
+namespace CommandParser
+{
+
+/**
+ * Publisher for a JoystickPublisher::Talker which hands every joystick update straight to a
+ * CommandParser::Listener in the same process: no broker hop and nothing serialized in between.
+ * The talker gives axes and buttons to handOverAxes() and handOverButton() as they are.
+ *
+ * If a @monitor is given, the talker also serializes each update in its wire format and publish()
+ * forwards it there, so that the raw joystick topics stay available for monitoring.
+ * Without a monitor nothing is serialized at all.
+ *
+ * @Monitor is any client exposing publish(topic, std::string), e.g. @MqttClient
+ */
+template <class Monitor>
+class LocalBridge
+{
+    Listener &listener_;
+    Monitor *monitor_;
+
+public:
+    LocalBridge(Listener &listener, Monitor *monitor = nullptr) : listener_(listener), monitor_(monitor) {}
+
+    void handOverAxes(const int *axes, int count)
+    {
+        if (count > 0)
+            listener_.setAxes(axes, count);
+    }
+
+    void handOverButton(int id, int value)
+    {
+        listener_.setButton(Button(id, value));
+    }
+
+    // It tells the talker whether the serialized updates are wanted
+    bool isMonitoring()
+    {
+        return monitor_ != nullptr;
+    }
+
+    // Serialized updates, for monitoring only
+    void publish(const std::string &topic, const std::string &payload)
+    {
+        if (monitor_ != nullptr)
+            monitor_->publish(topic, payload);
+    }
+};
+
+} // namespace CommandParser
+} // namespace Politocean
+
+#endif //LOCAL_BRIDGE_H
@@ -0,0 +1,299 @@
+#ifndef PUBLISH_SCHEDULER_H
+#define PUBLISH_SCHEDULER_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <mqttLogger.h>
+
+#include "Diagnostics.hpp"
+
+namespace Politocean
+{
+namespace CommandParser
+{
+
+/**
+ * Priority classes of the messages sent to the ROV, from the most urgent.
+ * @SAFETY   : emergency stop, motor power and reset. They go before anything else.
+ * @COMMANDS : every other button command, in the order they were pressed.
+ * @AXES     : actuator values. Only the newest value of each topic matters,
+ *             a value still queued when a newer one comes is dropped.
+ */
+enum class Priority
+{
+    SAFETY,
+    COMMANDS,
+    AXES
+};
+
+/**
+ * The only thread which publishes to the ROV: the talkers queue their messages here, by priority class,
+ * and a safety command never waits behind stick data. At most one message is in flight when it comes,
+ * since axes are queued one per topic and whatever was queued before it is not in the way.
+ *
+ * Queueing delays are recorded in the "commands.queue.safety", "commands.queue.commands" and
+ * "commands.queue.axes" histograms, stale axes dropped in the "commands.stale" counter.
+ * Messages are copied into preallocated slots: once warm, queueing does not allocate.
+ */
+class PublishScheduler
+{
+public:
+    static const int NUM_PRIORITIES = 3;
+
+    // Safety and button commands queued at once, and axes topics
+    static const std::size_t QUEUE_SIZE = 64;
+    static const std::size_t MAX_AXES_TOPICS = 8;
+
+    static const std::size_t PAYLOAD_CAPACITY = 256;
+
+private:
+    struct Message
+    {
+        std::string topic, payload;
+        uint64_t time = 0;
+        bool isPending = false;
+
+        Message()
+        {
+            topic.reserve(PAYLOAD_CAPACITY);
+            payload.reserve(PAYLOAD_CAPACITY);
+        }
+    };
+
+    /**
+     * Rings of QUEUE_SIZE messages for @SAFETY and @COMMANDS.
+     * @axes_ has a slot per topic, bound to it the first time the topic is queued.
+     */
+    struct Queue
+    {
+        std::vector<Message> messages;
+        std::size_t head = 0, count = 0;
+
+        Queue() : messages(QUEUE_SIZE) {}
+    };
+
+    Queue queues_[2];
+    std::vector<Message> axes_;
+    std::size_t pending_ = 0;
+
+    std::atomic<unsigned long> stale_{0};
+
+    std::thread *scheduler_ = nullptr;
+    bool isRunning_ = false;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    // Moves the most urgent message into @message. @mutex_ must be held and a message pending.
+    Priority pop(Message &message);
+
+public:
+    PublishScheduler() : axes_(MAX_AXES_TOPICS) {}
+    ~PublishScheduler()
+    {
+        stop();
+    }
+
+    /**
+     * Publishes every message queued, most urgent first, until stop() is called.
+     * @publisher is any client exposing publish(topic, std::string) and is_connected(), e.g. @MqttClient.
+     */
+    template <class Publisher>
+    void start(Publisher &publisher);
+
+    // Publishes what is still queued, then stops
+    void stop();
+
+    /**
+     * Queues @payload for @topic. Returns false if @priority's queue is full and the message is dropped:
+     * axes never are, they replace the value queued for @topic, if any.
+     */
+    bool push(Priority priority, const std::string &topic, const std::string &payload);
+
+    // Returns the number of axes updates replaced by a newer one before being sent
+    unsigned long getStale();
+
+    bool isRunning();
+};
+
+template <class Publisher>
+void PublishScheduler::start(Publisher &publisher)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (isRunning_)
+        return;
+
+    isRunning_ = true;
+
+    scheduler_ = new std::thread([this, &publisher]() {
+        static LatencyHistogram *queueLatency[NUM_PRIORITIES] = {
+            &Diagnostics::histogram("commands.queue.safety"),
+            &Diagnostics::histogram("commands.queue.commands"),
+            &Diagnostics::histogram("commands.queue.axes")};
+
+        Message message;
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        while (true)
+        {
+            cv_.wait(lock, [this]() { return !isRunning_ || pending_ > 0; });
+
+            // Stopped, and nothing left to send
+            if (pending_ == 0)
+                break;
+
+            Priority priority = pop(message);
+
+            lock.unlock();
+
+            queueLatency[(int)priority]->record(LatencyHistogram::now() - message.time);
+
+            if (publisher.is_connected())
+                publisher.publish(message.topic, message.payload);
+
+            lock.lock();
+        }
+    });
+}
+
+inline Priority PublishScheduler::pop(Message &message)
+{
+    Priority priority;
+
+    if (queues_[(int)Priority::SAFETY].count > 0 || queues_[(int)Priority::COMMANDS].count > 0)
+    {
+        priority = queues_[(int)Priority::SAFETY].count > 0 ? Priority::SAFETY : Priority::COMMANDS;
+        Queue &queue = queues_[(int)priority];
+
+        // Swapped rather than copied: both sides keep their capacity
+        std::swap(message, queue.messages[queue.head]);
+
+        queue.head = (queue.head + 1) % QUEUE_SIZE;
+        queue.count--;
+    }
+    else
+    {
+        priority = Priority::AXES;
+
+        // The topic waiting for the longest goes first, so that a busy one does not starve the others
+        Message *oldest = nullptr;
+        for (Message &slot : axes_)
+            if (slot.isPending && (oldest == nullptr || slot.time < oldest->time))
+                oldest = &slot;
+
+        message.topic = oldest->topic;
+        std::swap(message.payload, oldest->payload);
+        message.time = oldest->time;
+        oldest->isPending = false;
+    }
+
+    pending_--;
+
+    return priority;
+}
+
+inline bool PublishScheduler::push(Priority priority, const std::string &topic, const std::string &payload)
+{
+    static std::atomic<unsigned long> &staleCounter = Diagnostics::counter("commands.stale");
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (priority == Priority::AXES)
+        {
+            Message *slot = nullptr;
+            for (Message &axes : axes_)
+            {
+                if (axes.topic == topic || axes.topic.empty())
+                {
+                    slot = &axes;
+                    break;
+                }
+            }
+
+            if (slot == nullptr)
+            {
+                mqttLogger::getInstance().log(logger::WARNING, "Too many axes topics, " + topic + " dropped.");
+                return false;
+            }
+
+            if (slot->isPending)
+            {
+                stale_++;
+                staleCounter++;
+            }
+            else
+            {
+                // A stale value keeps its place in line
+                slot->time = LatencyHistogram::now();
+                slot->isPending = true;
+                pending_++;
+            }
+
+            if (slot->topic.empty())
+                slot->topic = topic;
+            slot->payload = payload;
+        }
+        else
+        {
+            Queue &queue = queues_[(int)priority];
+
+            if (queue.count == QUEUE_SIZE)
+            {
+                mqttLogger::getInstance().log(logger::WARNING, "Publish queue full, " + topic + " dropped.");
+                return false;
+            }
+
+            Message &message = queue.messages[(queue.head + queue.count++) % QUEUE_SIZE];
+            message.topic = topic;
+            message.payload = payload;
+            message.time = LatencyHistogram::now();
+
+            pending_++;
+        }
+    }
+
+    cv_.notify_one();
+
+    return true;
+}
+
+inline void PublishScheduler::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (!isRunning_)
+            return;
+
+        isRunning_ = false;
+    }
+    cv_.notify_one();
+
+    scheduler_->join();
+    delete scheduler_;
+    scheduler_ = nullptr;
+}
+
+inline unsigned long PublishScheduler::getStale()
+{
+    return stale_;
+}
+
+inline bool PublishScheduler::isRunning()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return isRunning_;
+}
+
+} // namespace CommandParser
+} // namespace Politocean
+
+#endif //PUBLISH_SCHEDULER_H
@@ -0,0 +1,94 @@
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+#include "Backoff.h"
+
+namespace Politocean
+{
+
+/**
+ * Collects state changes, e.g. a joystick hanging up or the broker going away, and lets the main thread
+ * sleep until one of them happens. Events are bits of an unsigned mask: any notify() wakes wait() up.
+ */
+class Supervisor
+{
+public:
+    enum Event : unsigned int
+    {
+        JOYSTICK_LOST = 1,
+        BROKER_LOST = 2
+    };
+
+private:
+    unsigned int events_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    std::vector<std::thread> watchers_;
+
+public:
+    ~Supervisor()
+    {
+        for (std::thread &watcher : watchers_)
+            watcher.join();
+    }
+
+    // It can be called from any thread, e.g. a joystick reading thread
+    void notify(unsigned int events)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            events_ |= events;
+        }
+        cv_.notify_all();
+    }
+
+    // Blocks until at least one event is notified, then returns and clears every pending event
+    unsigned int wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return events_ != 0; });
+
+        unsigned int events = events_;
+        events_ = 0;
+
+        return events;
+    }
+
+    // As wait(), but returns 0 once @timeout is over. Reconnection backoffs sleep here, so that they are cut short by any event.
+    unsigned int waitFor(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, timeout, [this]() { return events_ != 0; });
+
+        unsigned int events = events_;
+        events_ = 0;
+
+        return events;
+    }
+
+    /**
+     * Notifies @event as soon as @client disconnects.
+     * @Client is any client whose wait() blocks while it is connected, e.g. @MqttClient.
+     * @client must be disconnected before the supervisor is destroyed.
+     */
+    template <class Client>
+    void watch(Client &client, Event event)
+    {
+        watchers_.emplace_back([this, &client, event]() {
+            client.wait();
+            notify(event);
+        });
+    }
+};
+
+} // namespace Politocean
+
+#endif //SUPERVISOR_H
@@ -0,0 +1,114 @@
+#include <AxisConditioner.h>
+#include <algorithm>
+#include <cmath>
+
+namespace Politocean
+{
+
+const int AxisConditioner::SETTLE_PERIOD;
+
+AxisConditioner::AxisConditioner() : isEnabled_(false)
+{
+    setCurve(LINEAR_CURVE);
+}
+
+std::shared_ptr<const AxisConditioner::table_t> AxisConditioner::buildTable(const AxisCurve &curve)
+{
+    std::shared_ptr<table_t> table = std::make_shared<table_t>(MAX_VALUE + 1);
+
+    int deadzone = std::min(std::max(curve.deadzone, 0), MAX_VALUE - 1);
+    double expo = std::min(std::max(curve.expo, 0.0), 1.0);
+
+    for (int value = 0; value <= MAX_VALUE; value++)
+    {
+        if (value <= deadzone)
+        {
+            (*table)[value] = 0;
+            continue;
+        }
+
+        double x = (double)(value - deadzone) / (MAX_VALUE - deadzone);
+        double y = (1 - expo) * x + expo * x * x * x;
+
+        (*table)[value] = (int16_t)std::lround(y * MAX_VALUE);
+    }
+
+    return table;
+}
+
+std::shared_ptr<const AxisConditioner::table_t> AxisConditioner::findTable(const AxisCurve &curve)
+{
+    for (const Axis &axis : axes_)
+    {
+        if (axis.table && axis.curve.deadzone == curve.deadzone && axis.curve.expo == curve.expo)
+            return axis.table;
+    }
+
+    return buildTable(curve);
+}
+
+void AxisConditioner::setCurve(const AxisCurve &curve)
+{
+    for (int axis = 0; axis < MAX_AXES; axis++)
+        setCurve(axis, curve);
+}
+
+void AxisConditioner::setCurve(int axis, const AxisCurve &curve)
+{
+    if (axis < 0 || axis >= MAX_AXES)
+        return;
+
+    Axis &state = axes_[axis];
+
+    state.table = findTable(curve);
+    state.curve = curve;
+    state.alpha = std::lround(std::min(std::max(curve.smoothing, 0.0), 1.0) * (1 << 16));
+    state.state = 0;
+    state.target = 0;
+
+    // A zero weight would freeze the axis
+    if (state.alpha == 0)
+        state.alpha = 1;
+
+    isEnabled_ = std::any_of(axes_, axes_ + MAX_AXES, [](const Axis &a) { return !(a.curve == LINEAR_CURVE); });
+}
+
+const AxisCurve &AxisConditioner::getCurve(int axis)
+{
+    return axes_[std::min(std::max(axis, 0), MAX_AXES - 1)].curve;
+}
+
+bool AxisConditioner::isEnabled()
+{
+    return isEnabled_;
+}
+
+int AxisConditioner::reset(int axis, int value)
+{
+    if (axis < 0 || axis >= MAX_AXES)
+        return value;
+
+    Axis &state = axes_[axis];
+    int32_t alpha = state.alpha;
+
+    // Unfiltered for a single value: the filter ends up exactly on it
+    state.alpha = 1 << 16;
+    int shaped = apply(axis, value);
+    state.alpha = alpha;
+
+    state.state = (int64_t)shaped << 16;
+    state.target = shaped;
+
+    return shaped;
+}
+
+void AxisConditioner::center()
+{
+    for (Axis &state : axes_)
+    {
+        state.state = 0;
+        state.target = 0;
+    }
+}
+
+} // namespace Politocean
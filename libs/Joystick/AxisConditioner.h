@@ -0,0 +1,156 @@
+#ifndef AXIS_CONDITIONER_H
+#define AXIS_CONDITIONER_H
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+namespace Politocean
+{
+
+/**
+ * Response of an axis, symmetric around the center.
+ * @deadzone    : values within ±deadzone read as 0, the rest of the range is stretched back to full scale.
+ * @expo        : 0 is linear, 1 fully cubic. Small deflections get finer, full deflection stays full.
+ * @smoothing   : weight of each new value in a low-pass filter, 1 leaves the axis unfiltered.
+ */
+struct AxisCurve
+{
+    int deadzone;
+    double expo;
+    double smoothing;
+
+    bool operator==(const AxisCurve &other) const
+    {
+        return deadzone == other.deadzone && expo == other.expo && smoothing == other.smoothing;
+    }
+};
+
+const AxisCurve LINEAR_CURVE = {0, 0, 1};
+
+/**
+ * Conditions raw axis values, in the joydev range [-32767, 32767], before they reach the joystick state.
+ * Deadzone and expo are baked into a lookup table per curve when it is set, so conditioning a value
+ * costs a table index plus, for filtered axes, one fixed-point multiply-add.
+ * Devices only report changes, so a filtered axis is also moved on by settle(), every SETTLE_PERIOD
+ * milliseconds, until it reaches the last value: a released stick always ends up centered.
+ * Curves must be set before the joystick starts reading: apply() is not synchronized with them.
+ */
+class AxisConditioner
+{
+public:
+    static const int MAX_VALUE = 32767;
+    static const int MAX_AXES = 32;
+
+    // Milliseconds between two filter steps while no event comes
+    static const int SETTLE_PERIOD = 10;
+
+private:
+    // Output for each magnitude 0..MAX_VALUE, the sign is applied afterwards
+    typedef std::vector<int16_t> table_t;
+
+    struct Axis
+    {
+        AxisCurve curve = LINEAR_CURVE;
+        std::shared_ptr<const table_t> table;
+
+        // Low-pass weight and filtered value, both in Q16 fixed point, and the value it is heading to
+        int32_t alpha = 1 << 16;
+        int64_t state = 0;
+        int target = 0;
+    };
+
+    Axis axes_[MAX_AXES];
+    bool isEnabled_;
+
+    static std::shared_ptr<const table_t> buildTable(const AxisCurve &curve);
+
+    // Reuses the table of an axis with the same curve, if any
+    std::shared_ptr<const table_t> findTable(const AxisCurve &curve);
+
+    // Moves the filter of @state one step towards its target and returns the filtered value
+    static int step(Axis &state)
+    {
+        int64_t target = (int64_t)state.target << 16;
+        int64_t delta = (state.alpha * (target - state.state)) >> 16;
+
+        // Once the steps are below the fixed-point resolution the filter would stall short of the target
+        state.state = delta != 0 ? state.state + delta : target;
+
+        return (int)((state.state + (1 << 15)) >> 16);
+    }
+
+public:
+    AxisConditioner();
+
+    // @curve applies to every axis
+    void setCurve(const AxisCurve &curve);
+    void setCurve(int axis, const AxisCurve &curve);
+
+    const AxisCurve &getCurve(int axis);
+
+    // False while every axis is linear and unfiltered: the joystick then skips conditioning altogether
+    bool isEnabled();
+
+    /**
+     * Returns the conditioned @value of @axis and moves its filter on.
+     * Axes beyond MAX_AXES are passed through.
+     */
+    int apply(int axis, int value)
+    {
+        if (axis < 0 || axis >= MAX_AXES)
+            return value;
+
+        Axis &state = axes_[axis];
+
+        if (value < -MAX_VALUE)
+            value = -MAX_VALUE;
+        else if (value > MAX_VALUE)
+            value = MAX_VALUE;
+
+        int shaped = value < 0 ? -(*state.table)[-value] : (*state.table)[value];
+
+        state.target = shaped;
+
+        // A centered stick stops the axis at once, it is never eased back
+        if (state.alpha == 1 << 16 || shaped == 0)
+        {
+            state.state = (int64_t)shaped << 16;
+            return shaped;
+        }
+
+        return step(state);
+    }
+
+    /**
+     * Moves the filter of @axis one step towards the last value applied, without a new one.
+     * Returns the filtered value.
+     */
+    int settle(int axis)
+    {
+        if (axis < 0 || axis >= MAX_AXES)
+            return 0;
+
+        return step(axes_[axis]);
+    }
+
+    // True once every filtered axis reached the last value applied to it
+    bool isSettled()
+    {
+        for (const Axis &state : axes_)
+            if (state.state != (int64_t)state.target << 16)
+                return false;
+
+        return true;
+    }
+
+    // Returns the conditioned @value of @axis with its filter settled on it, as for an initial state
+    int reset(int axis, int value);
+
+    // Settles every filter on a centered stick, e.g. before a new device is read
+    void center();
+};
+
+} // namespace Politocean
+
+#endif //AXIS_CONDITIONER_H
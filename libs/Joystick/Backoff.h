@@ -0,0 +1,44 @@
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include <chrono>
+#include <algorithm>
+
+namespace Politocean
+{
+
+/**
+ * Delays between two reconnection attempts: @initial at first, doubled at every attempt up to @maximum.
+ */
+class Backoff
+{
+public:
+    static const int DFLT_INITIAL = 100;
+    static const int DFLT_MAXIMUM = 8000;
+
+private:
+    std::chrono::milliseconds initial_, maximum_, next_;
+
+public:
+    Backoff(int initial = DFLT_INITIAL, int maximum = DFLT_MAXIMUM)
+        : initial_(initial), maximum_(maximum), next_(initial) {}
+
+    // Returns the delay before the next attempt
+    std::chrono::milliseconds next()
+    {
+        std::chrono::milliseconds delay = next_;
+        next_ = std::min(next_ * 2, maximum_);
+
+        return delay;
+    }
+
+    // Starts over from @initial, once an attempt succeeded
+    void reset()
+    {
+        next_ = initial_;
+    }
+};
+
+} // namespace Politocean
+
+#endif //BACKOFF_H
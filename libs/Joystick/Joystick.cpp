@@ -5,8 +5,13 @@
 #include <Joystick.h>
 #include <fcntl.h>
 #include <sstream>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
 #include <unistd.h>
+#include <poll.h>
 #include <sys/ioctl.h>
+#include <sys/eventfd.h>
 #include <mqttLogger.h>
 
 #include <PolitoceanExceptions.hpp>
@@ -15,35 +20,224 @@ namespace Politocean
 {
 
 const std::string Joystick::DFLT_DEVICE{"/dev/input/js0"};
+const std::string Joystick::DFLT_EVDEV_DEVICE{"/dev/input/event0"};
+
+static const int LONG_BITS = sizeof(unsigned long) * 8;
+
+static bool testBit(const unsigned long *bits, int bit)
+{
+    return (bits[bit / LONG_BITS] >> (bit % LONG_BITS)) & 1UL;
+}
 
 void Joystick::connect()
 {
+    if (fd != -1)
+        close(fd);
+
     if ((fd = open(device_.c_str(), O_RDONLY)) == -1)
         throw JoystickException("Joystick device not found.");
 
-    ioctl(fd, JSIOCGAXES, &num_of_axes);
-    ioctl(fd, JSIOCGBUTTONS, &num_of_buttons);
-    ioctl(fd, JSIOCGNAME(80), name_of_joystick);
+    memset(name_of_joystick, 0, sizeof(name_of_joystick));
+
+    if (backend_ == Backend::EVDEV)
+        connectEvdev();
+    else
+        connectJoydev();
 
     // Logging
     std::stringstream info;
-    info << "Joystick detected: " << name_of_joystick << "\n\t";
+    info << "Joystick detected: " << name_of_joystick << (backend_ == Backend::EVDEV ? " (evdev)" : "") << "\n\t";
     info << num_of_axes << " axis\n\t";
     info << num_of_buttons << "buttons";
     mqttLogger::getInstance(LIB_TAG).log(logger::CONFIG, info.str());
     // End logging
 
-    axes_.resize(num_of_axes, 0);
-
     fcntl(fd, F_SETFL, O_NONBLOCK);
 
     isConnected_ = true;
+
+    // Let the reading thread, if any, start polling the new file descriptor
+    wakeUp();
+}
+
+void Joystick::disconnect()
+{
+    isConnected_ = false;
+
+    if (fd != -1)
+        close(fd);
+    fd = -1;
+}
+
+void Joystick::reset()
+{
+    ButtonEvent event;
+    while (buttonEvents_.pop(event))
+        ;
+
+    droppedButtons_ = 0;
+    button_ = 0;
+
+    std::fill(axes_.begin(), axes_.end(), 0);
+    std::fill(frame_.begin(), frame_.end(), 0);
+    std::fill(keys_.begin(), keys_.end(), 0);
+    isSyncDropped_ = false;
+    coalescedEvents_ = 0;
+    lastEventTime_ = 0;
+
+    conditioner_.center();
+}
+
+void Joystick::setDevice(const std::string &device)
+{
+    device_ = device;
+}
+
+const std::string &Joystick::getDevice()
+{
+    return device_;
+}
+
+void Joystick::connectJoydev()
+{
+    // A stream of js_events which is not a joydev device, e.g. a pipe, is sized by its initial state events
+    unsigned char axes = 0, buttons = 0;
+    ioctl(fd, JSIOCGAXES, &axes);
+    ioctl(fd, JSIOCGBUTTONS, &buttons);
+    if (ioctl(fd, JSIOCGNAME(80), name_of_joystick) < 0)
+        strcpy(name_of_joystick, "Unknown");
+
+    num_of_axes = axes;
+    num_of_buttons = buttons;
+    axes_.assign(num_of_axes, 0);
+}
+
+void Joystick::connectEvdev()
+{
+    unsigned long absBits[ABS_CNT / LONG_BITS + 1] = {0};
+    unsigned long keyBits[KEY_CNT / LONG_BITS + 1] = {0};
+
+    if (ioctl(fd, EVIOCGNAME(sizeof(name_of_joystick) - 1), name_of_joystick) < 0 ||
+        ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(absBits)), absBits) < 0 ||
+        ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits) < 0)
+    {
+        close(fd);
+        fd = -1;
+        throw JoystickException("Joystick device is not an evdev device.");
+    }
+
+    // Axes are numbered in code order, as joydev does
+    absMap_.assign(ABS_CNT, -1);
+    axesInfo_.clear();
+    for (int code = 0; code < ABS_CNT; code++)
+    {
+        if (!testBit(absBits, code))
+            continue;
+
+        struct input_absinfo abs;
+        if (ioctl(fd, EVIOCGABS(code), &abs) < 0)
+            continue;
+
+        absMap_[code] = axesInfo_.size();
+        axesInfo_.push_back(AxisInfo{code, abs.minimum, abs.maximum, abs.fuzz, abs.flat});
+    }
+    num_of_axes = axesInfo_.size();
+
+    // Buttons are numbered from BTN_JOYSTICK first and then from BTN_MISC, as joydev does
+    keyMap_.assign(KEY_CNT, -1);
+    num_of_buttons = 0;
+    for (int code = BTN_JOYSTICK; code < KEY_CNT; code++)
+        if (testBit(keyBits, code))
+            keyMap_[code] = num_of_buttons++;
+    for (int code = BTN_MISC; code < BTN_JOYSTICK; code++)
+        if (testBit(keyBits, code))
+            keyMap_[code] = num_of_buttons++;
+
+    axes_.assign(num_of_axes, 0);
+    frame_.assign(num_of_axes, 0);
+    keys_.assign(num_of_buttons, 0);
+    isSyncDropped_ = false;
+
+    // Buttons already held are the initial state, not transitions
+    syncEvdev(0, false);
+    axes_ = frame_;
+}
+
+void Joystick::syncEvdev(uint64_t time, bool isResync)
+{
+    for (int i = 0; i < num_of_axes; i++)
+    {
+        struct input_absinfo abs;
+        if (ioctl(fd, EVIOCGABS(axesInfo_[i].code), &abs) == 0)
+        {
+            frame_[i] = scaleAxis(i, abs.value);
+            if (conditioner_.isEnabled())
+                frame_[i] = conditioner_.reset(i, frame_[i]);
+        }
+    }
+
+    unsigned long keyState[KEY_CNT / LONG_BITS + 1] = {0};
+    if (ioctl(fd, EVIOCGKEY(sizeof(keyState)), keyState) < 0)
+        return;
+
+    for (int code = 0; code < KEY_CNT; code++)
+    {
+        int id = keyMap_[code];
+        unsigned char value = testBit(keyState, code);
+
+        if (id == -1 || keys_[id] == value)
+            continue;
+
+        keys_[id] = value;
+
+        if (!isResync)
+            continue;
+
+        button_ = (value << 7) | id;
+
+        if (!buttonEvents_.push(ButtonEvent{(unsigned char)id, value, time}))
+            droppedButtons_++;
+    }
+}
+
+int Joystick::scaleAxis(int index, int value)
+{
+    const AxisInfo &info = axesInfo_[index];
+
+    if (info.maximum <= info.minimum)
+        return 0;
+
+    long long scaled = (long long)(value - info.minimum) * 65534 / (info.maximum - info.minimum) - 32767;
+
+    if (scaled < -32767)
+        return -32767;
+    if (scaled > 32767)
+        return 32767;
+    return scaled;
 }
 
 Joystick::~Joystick()
 {
+    stopReading();
+
     isConnected_ = false;
-    close(fd);
+    if (fd != -1)
+        close(fd);
+    if (wakeFd_ != -1)
+        close(wakeFd_);
+}
+
+void Joystick::startReading(callback_t callback)
+{
+    if (isReading())
+        return;
+
+    if (wakeFd_ == -1 && (wakeFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1)
+        throw JoystickException("Cannot create joystick wake up descriptor.");
+
+    isReading_ = true;
+
+    readingThread_ = new std::thread(&Joystick::readingLoop, this, callback);
 }
 
 void Joystick::stopReading()
@@ -52,21 +246,250 @@ void Joystick::stopReading()
         return;
 
     isReading_ = false;
+    wakeUp();
+
     readingThread_->join();
+    delete readingThread_;
+    readingThread_ = nullptr;
+}
+
+void Joystick::wakeUp()
+{
+    if (wakeFd_ == -1)
+        return;
+
+    uint64_t one = 1;
+    if (write(wakeFd_, &one, sizeof(one)) == -1 && errno != EAGAIN)
+        mqttLogger::getInstance(LIB_TAG).log(logger::ERROR, "Cannot wake up joystick reading thread.");
+}
+
+void Joystick::readingLoop(callback_t callback)
+{
+    struct pollfd fds[2];
+
+    fds[0].fd = wakeFd_;
+    fds[0].events = POLLIN;
+
+    while (isReading_)
+    {
+        // The device is polled only while connected: a dead fd would make poll return immediately.
+        bool connected = isConnected_;
+
+        fds[1].fd = connected ? fd : -1;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+
+        // Filtered axes still on their way to the stick position are moved on even if no event comes
+        bool isSettling = connected && conditioner_.isEnabled() && !conditioner_.isSettled();
+
+        int ready = poll(fds, 2, isSettling ? AxisConditioner::SETTLE_PERIOD : -1);
+        if (ready == -1)
+        {
+            if (errno == EINTR)
+                continue;
+
+            mqttLogger::getInstance(LIB_TAG).log(logger::ERROR, "Polling joystick failed.");
+            break;
+        }
+
+        if (ready == 0)
+        {
+            settleAxes();
+            callback(axes_, button_);
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            uint64_t count;
+            while (read(wakeFd_, &count, sizeof(count)) > 0)
+                ;
+        }
+
+        if (!connected)
+            continue;
+
+        if (fds[1].revents & POLLIN)
+        {
+            if (readData() > 0)
+                callback(axes_, button_);
+        }
+        else if (fds[1].revents & (POLLERR | POLLHUP | POLLNVAL))
+            hangUp();
+    }
+}
+
+void Joystick::settleAxes()
+{
+    std::size_t count = std::min(axes_.size(), (std::size_t)AxisConditioner::MAX_AXES);
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        axes_[i] = conditioner_.settle(i);
+
+        // The evdev frame being collected starts from the settled values too
+        if (i < frame_.size())
+            frame_[i] = axes_[i];
+    }
+}
+
+void Joystick::hangUp()
+{
+    // Only the first hang up of a connection is notified
+    if (isConnected_.exchange(false) && onDisconnect_)
+        onDisconnect_();
+}
+
+unsigned int Joystick::readData()
+{
+    using std::chrono::steady_clock;
+
+    steady_clock::time_point start;
+    if (onRead_)
+        start = steady_clock::now();
+
+    unsigned int count = backend_ == Backend::EVDEV ? readEvdev() : readJoydev();
+
+    if (count > 0)
+    {
+        coalescedEvents_ = count;
+        if (onRead_)
+            onRead_(std::chrono::duration_cast<std::chrono::nanoseconds>(steady_clock::now() - start).count());
+    }
+
+    return count;
+}
+
+unsigned int Joystick::readJoydev()
+{
+    unsigned int count = 0;
+    ssize_t num_bytes;
+
+    while ((num_bytes = read(fd, events_, sizeof(events_))) > 0)
+    {
+        int num_events = num_bytes / sizeof(struct js_event);
+        for (int i = 0; i < num_events; i++)
+            applyEvent(events_[i]);
+
+        JoystickRecorder *recorder = recorder_;
+        if (recorder != nullptr)
+            recorder->record(events_, num_events);
+
+        count += num_events;
+
+        // A short read means the kernel queue has been drained
+        if (num_bytes < (ssize_t)sizeof(events_))
+            break;
+    }
+
+    if (num_bytes == -1 && errno == ENODEV)
+        hangUp();
+
+    return count;
 }
 
-void Joystick::readData()
+unsigned int Joystick::readEvdev()
 {
-    if ((read(fd, &js, sizeof(struct js_event))) == -1 && errno == ENODEV)
-        isConnected_ = false;
+    unsigned int count = 0;
+    ssize_t num_bytes;
+
+    while ((num_bytes = read(fd, inputEvents_, sizeof(inputEvents_))) > 0)
+    {
+        int num_events = num_bytes / sizeof(struct input_event);
+        for (int i = 0; i < num_events; i++)
+            applyEvent(inputEvents_[i]);
+
+        count += num_events;
+
+        if (num_bytes < (ssize_t)sizeof(inputEvents_))
+            break;
+    }
+
+    if (num_bytes == -1 && errno == ENODEV)
+        hangUp();
+
+    return count;
+}
+
+void Joystick::applyEvent(const struct js_event &js)
+{
+    uint64_t time = js.time * 1000ULL;
 
     switch (js.type & ~JS_EVENT_INIT)
     {
     case JS_EVENT_AXIS:
-        axes_[js.number] = js.value;
+        if ((js.type & JS_EVENT_INIT) && js.number >= axes_.size())
+            axes_.resize(num_of_axes = js.number + 1, 0);
+        if (js.number < axes_.size())
+        {
+            int value = js.value;
+
+            // The initial state settles the filter, instead of being smoothed in from 0
+            if (conditioner_.isEnabled())
+                value = (js.type & JS_EVENT_INIT) ? conditioner_.reset(js.number, value) : conditioner_.apply(js.number, value);
+
+            axes_[js.number] = value;
+        }
+        lastEventTime_ = time;
         break;
     case JS_EVENT_BUTTON:
         button_ = (js.value << 7) | js.number;
+
+        // Initial state events are not transitions
+        if (!(js.type & JS_EVENT_INIT) && !buttonEvents_.push(ButtonEvent{js.number, (unsigned char)js.value, time}))
+            droppedButtons_++;
+        break;
+    }
+}
+
+void Joystick::applyEvent(const struct input_event &ev)
+{
+    uint64_t time = ev.input_event_sec * 1000000ULL + ev.input_event_usec;
+
+    switch (ev.type)
+    {
+    case EV_ABS:
+        // Axis values are held back until the frame is complete
+        if (!isSyncDropped_ && ev.code < absMap_.size() && absMap_[ev.code] != -1)
+        {
+            int index = absMap_[ev.code];
+
+            frame_[index] = scaleAxis(index, ev.value);
+            if (conditioner_.isEnabled())
+                frame_[index] = conditioner_.apply(index, frame_[index]);
+        }
+        break;
+    case EV_KEY:
+    {
+        // Autorepeat (value 2) is not a transition
+        if (isSyncDropped_ || ev.code >= keyMap_.size() || keyMap_[ev.code] == -1 || ev.value > 1)
+            break;
+
+        unsigned char id = keyMap_[ev.code];
+        button_ = (ev.value << 7) | id;
+        keys_[id] = ev.value;
+
+        if (!buttonEvents_.push(ButtonEvent{id, (unsigned char)ev.value, time}))
+            droppedButtons_++;
+        break;
+    }
+    case EV_SYN:
+        if (ev.code == SYN_DROPPED)
+        {
+            // The kernel buffer overflowed: ignore events up to the next SYN_REPORT and resync then
+            isSyncDropped_ = true;
+        }
+        else if (ev.code == SYN_REPORT)
+        {
+            if (isSyncDropped_)
+            {
+                syncEvdev(time, true);
+                isSyncDropped_ = false;
+            }
+
+            axes_ = frame_;
+            lastEventTime_ = time;
+        }
         break;
     }
 }
@@ -81,6 +504,61 @@ unsigned char Joystick::getButton()
     return button_;
 }
 
+bool Joystick::nextButton(ButtonEvent &event)
+{
+    return buttonEvents_.pop(event);
+}
+
+bool Joystick::isButtonUpdated()
+{
+    return !buttonEvents_.empty();
+}
+
+unsigned int Joystick::getDroppedButtons()
+{
+    return droppedButtons_;
+}
+
+void Joystick::setRecorder(JoystickRecorder *recorder)
+{
+    recorder_ = recorder;
+}
+
+void Joystick::onDisconnect(disconnect_handler_t handler)
+{
+    onDisconnect_ = handler;
+}
+
+void Joystick::onRead(read_handler_t handler)
+{
+    onRead_ = handler;
+}
+
+void Joystick::setConditioner(const AxisConditioner &conditioner)
+{
+    conditioner_ = conditioner;
+}
+
+unsigned int Joystick::getCoalescedEvents()
+{
+    return coalescedEvents_;
+}
+
+uint64_t Joystick::getLastEventTime()
+{
+    return lastEventTime_;
+}
+
+const std::vector<AxisInfo> &Joystick::getAxesInfo()
+{
+    return axesInfo_;
+}
+
+Joystick::Backend Joystick::getBackend()
+{
+    return backend_;
+}
+
 bool Joystick::isReading()
 {
     return isReading_;
@@ -6,27 +6,99 @@
 #define JOYSTICK_H
 
 #include <linux/joystick.h>
+#include <linux/input.h>
+
+#include "RingBuffer.h"
+#include "JoystickRecorder.h"
+#include "AxisConditioner.h"
 
 #include <string>
+#include <cstdint>
 #include <vector>
 #include <thread>
-#include <chrono>
+#include <atomic>
 #include <exception>
 #include <functional>
 
 namespace Politocean
 {
 
+/**
+ * A single button transition, stamped with the kernel @time in microseconds.
+ * The joydev backend only has millisecond resolution.
+ */
+struct ButtonEvent
+{
+    unsigned char id;
+    unsigned char value;
+    uint64_t time;
+};
+
+/**
+ * Range reported by the evdev backend for an axis through EVIOCGABS.
+ */
+struct AxisInfo
+{
+    int code;
+    int minimum, maximum;
+    int fuzz, flat;
+};
+
 class Joystick
 {
+public:
+    typedef std::function<void(const std::vector<int> &axes, unsigned char button)> callback_t;
+    typedef std::function<void()> disconnect_handler_t;
+    typedef std::function<void(uint64_t duration)> read_handler_t;
+
+    /**
+     * @JOYDEV reads the legacy /dev/input/jsN interface.
+     * @EVDEV reads /dev/input/eventN and publishes axes once per EV_SYN frame.
+     */
+    enum class Backend
+    {
+        JOYDEV,
+        EVDEV
+    };
+
+private:
     const std::string LIB_TAG = "Joystick";
     std::string device_;
+    Backend backend_;
 
     int fd, num_of_axes, num_of_buttons;
     char name_of_joystick[80];
-    struct js_event js;
 
-    bool isReading_, isConnected_;
+    /**
+     * @events_ receives every pending event in a single read.
+     * @coalescedEvents_ counts the events applied before the last callback.
+     */
+    static const int EVENTS_BUFFER_SIZE = 64;
+    struct js_event events_[EVENTS_BUFFER_SIZE];
+    struct input_event inputEvents_[EVENTS_BUFFER_SIZE];
+    std::atomic<unsigned int> coalescedEvents_;
+
+    /**
+     * evdev state: @absMap_ and @keyMap_ translate event codes into joydev-like indexes,
+     * @frame_ collects axis values until the EV_SYN which closes the frame
+     * and @keys_ holds the last known value of every button, to resync them after an overflow.
+     */
+    std::vector<int> absMap_, keyMap_;
+    std::vector<int> frame_;
+    std::vector<unsigned char> keys_;
+    std::vector<AxisInfo> axesInfo_;
+    bool isSyncDropped_;
+
+    // Timestamp in microseconds of the last event applied to the state
+    std::atomic<uint64_t> lastEventTime_;
+
+    /**
+     * @wakeFd_ is an eventfd polled by the reading thread together with @fd.
+     * Writing to it wakes the thread up, either to stop or to pick up a new @fd.
+     */
+    int wakeFd_;
+
+    std::atomic<bool> isReading_, isConnected_;
 
     /**
      * @axes and @buttons maps store respectively values for joystick axes and buttons.
@@ -34,17 +106,61 @@ class Joystick
     std::vector<int> axes_;
     unsigned char button_;
 
+    /**
+     * @buttonEvents_ keeps every button transition until the consumer drains it.
+     * @droppedButtons_ counts transitions lost because the queue was full.
+     */
+    static const std::size_t BUTTON_QUEUE_SIZE = 256;
+    RingBuffer<ButtonEvent, BUTTON_QUEUE_SIZE> buttonEvents_;
+    std::atomic<unsigned int> droppedButtons_;
+
+    // @recorder_, if set, gets every raw js_event read
+    std::atomic<JoystickRecorder *> recorder_;
+
+    // Deadzone, expo and filtering of every axis value on its way into @axes_
+    AxisConditioner conditioner_;
+
     /*
-     * Reads data from joystick and stores them.
+     * Drains every pending event from joystick and stores them.
+     * Returns the number of events read.
      */
-    void readData();
+    unsigned int readData();
+    unsigned int readJoydev();
+    unsigned int readEvdev();
+    void applyEvent(const struct js_event &js);
+    void applyEvent(const struct input_event &ev);
 
-    std::thread *readingThread_;
+    void connectJoydev();
+    void connectEvdev();
+    /**
+     * Reloads axes and buttons from the device. On a resync after SYN_DROPPED, every button which changed
+     * meanwhile is queued as a transition stamped @time, so that a lost release is not a button held forever.
+     */
+    void syncEvdev(uint64_t time, bool isResync);
+
+    // Moves every filtered axis one step on towards the last value read, from the reading thread
+    void settleAxes();
+    int scaleAxis(int index, int value);
 
-    const int SLEEP_TIME = 5; //ms
+    /*
+     * Blocks on @fd and @wakeFd_ and calls @callback as soon as the kernel delivers an event.
+     */
+    void readingLoop(callback_t callback);
+    void startReading(callback_t callback);
+    void wakeUp();
+
+    // Marks the device as gone and calls @onDisconnect_, from the reading thread
+    void hangUp();
+    disconnect_handler_t onDisconnect_;
+
+    // Called after every read which returned events, see onRead()
+    read_handler_t onRead_;
+
+    std::thread *readingThread_;
 
 public:
     static const std::string DFLT_DEVICE;
+    static const std::string DFLT_EVDEV_DEVICE;
     /**
      * Opens the joystick file descriptor @fd.
      * It throws a @JoystickException if the open fails.
@@ -52,8 +168,8 @@ public:
 
     Joystick() : Joystick(DFLT_DEVICE) {}
 
-    Joystick(const std::string &device)
-        : device_(device), num_of_axes(0), num_of_buttons(0), isReading_(false), isConnected_(false), button_(0), readingThread_(nullptr) {}
+    Joystick(const std::string &device, Backend backend = Backend::JOYDEV)
+        : device_(device), backend_(backend), fd(-1), num_of_axes(0), num_of_buttons(0), coalescedEvents_(0), isSyncDropped_(false), lastEventTime_(0), wakeFd_(-1), isReading_(false), isConnected_(false), button_(0), droppedButtons_(0), recorder_(nullptr), readingThread_(nullptr) {}
     /**
      * Closes the joystick file descriptor @fd.
      */
@@ -61,6 +177,23 @@ public:
 
     void connect();
 
+    /**
+     * Closes the joystick file descriptor @fd, so that a later connect() starts over.
+     * It must be called while the joystick is not reading.
+     */
+    void disconnect();
+
+    /**
+     * Forgets the axes, the queued button transitions and the filter states of the previous connection,
+     * so that a joystick reused for a new device never replays stale presses.
+     * It must be called while the joystick is not reading and nobody takes buttons from it.
+     */
+    void reset();
+
+    // The device opened by the next connect()
+    void setDevice(const std::string &device);
+    const std::string &getDevice();
+
     /**
      * Returns a thread which is listening to the joystick.
      * @fp is a pointer to the method function
@@ -69,24 +202,10 @@ public:
     template <class M, class T>
     void startReading(void (T::*fp)(const std::vector<int> &axes, unsigned char button), M *obj)
     {
-        if (isReading())
-            return;
-
-        isReading_ = true;
-
-        auto callbackFunction = std::bind(fp, obj, std::placeholders::_1, std::placeholders::_2);
-
-        readingThread_ = new std::thread([this, callbackFunction]() {
-            while (isReading_)
-            {
-                std::this_thread::sleep_for(std::chrono::milliseconds(SLEEP_TIME));
-                readData();
-                callbackFunction(axes_, button_);
-            }
-        });
+        startReading(std::bind(fp, obj, std::placeholders::_1, std::placeholders::_2));
     }
     /**
-     * It stops the listening thread by setting @_isListening to false.
+     * It stops the listening thread by setting @_isListening to false and waking it up.
      */
     void stopReading();
 
@@ -96,6 +215,53 @@ public:
     int getAxis(int axis);
     unsigned char getButton();
 
+    /**
+     * Pops the oldest button transition into @event, without locking.
+     * It must be called by a single consumer thread. Returns false if there is none.
+     */
+    bool nextButton(ButtonEvent &event);
+    bool isButtonUpdated();
+    unsigned int getDroppedButtons();
+
+    /**
+     * Records every raw event read from now on into @recorder, until it is set to nullptr.
+     * Only the joydev backend is recorded. @recorder must outlive the recording.
+     */
+    void setRecorder(JoystickRecorder *recorder);
+
+    /**
+     * @handler is called by the reading thread as soon as the device hangs up, e.g. when it is unplugged,
+     * so that nobody has to poll isConnected(). It is not called by disconnect().
+     * It must be set while the joystick is not reading, and must not block.
+     */
+    void onDisconnect(disconnect_handler_t handler);
+
+    /**
+     * @handler is called by the reading thread after every read which returned events, with the time it took
+     * in nanoseconds, e.g. to record it in a latency histogram. Reads are not timed while it is not set.
+     * It must be set while the joystick is not reading, and must not block.
+     */
+    void onRead(read_handler_t handler);
+
+    /**
+     * Conditions every axis value read from now on through @conditioner. Raw events are still the ones recorded.
+     * It must be called while the joystick is not reading.
+     */
+    void setConditioner(const AxisConditioner &conditioner);
+
+    // Returns the number of events merged into the state handed to the last callback
+    unsigned int getCoalescedEvents();
+
+    // Returns the kernel timestamp, in microseconds, of the last event applied to the axes
+    uint64_t getLastEventTime();
+
+    /**
+     * Returns min/max/fuzz/flat of each axis. Only the evdev backend fills it,
+     * axis values are anyway scaled to the joydev range [-32767, 32767].
+     */
+    const std::vector<AxisInfo> &getAxesInfo();
+    Backend getBackend();
+
     // Returns true is the thread is reading for joystick values
     bool isReading();
     // Returns true if the joystick device is connected
@@ -0,0 +1,85 @@
+#ifndef JOYSTICK_LOG_H
+#define JOYSTICK_LOG_H
+
+#include <linux/joystick.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Politocean
+{
+
+/**
+ * Binary log of a joystick session, as written by @JoystickRecorder and read by @JoystickPlayer.
+ * A HEADER_SIZE header is followed by RECORD_SIZE records, all little endian:
+ *
+ *  header  0..3  MAGIC
+ *          4     VERSION
+ *          5     RECORD_SIZE
+ *          6..7  reserved
+ *
+ *  record  0..3  microseconds since the previous record
+ *          4..5  js_event value
+ *          6     js_event type, WAIT for a record which only carries time
+ *          7     js_event number
+ *
+ * Times are those the kernel stamped the events with. Events of the same millisecond are 0 microseconds apart,
+ * so a record usually costs 8 bytes and no more.
+ */
+namespace JoystickLog
+{
+
+const char MAGIC[4] = {'P', 'J', 'S', 'L'};
+const uint8_t VERSION = 1;
+
+const std::size_t HEADER_SIZE = 8;
+const std::size_t RECORD_SIZE = 8;
+
+// Never a js_event type: the record only moves time forward, for gaps longer than a record can hold
+const uint8_t WAIT = 0;
+const uint32_t MAX_DELTA = 0xFFFFFFFF;
+
+inline void encodeHeader(char *buffer)
+{
+    for (int i = 0; i < 4; i++)
+        buffer[i] = MAGIC[i];
+    buffer[4] = VERSION;
+    buffer[5] = RECORD_SIZE;
+    buffer[6] = buffer[7] = 0;
+}
+
+inline bool isHeader(const char *buffer)
+{
+    for (int i = 0; i < 4; i++)
+        if (buffer[i] != MAGIC[i])
+            return false;
+
+    return (uint8_t)buffer[4] == VERSION && (uint8_t)buffer[5] == RECORD_SIZE;
+}
+
+inline void encodeRecord(char *buffer, uint32_t delta, uint8_t type, uint8_t number, int16_t value)
+{
+    for (int i = 0; i < 4; i++)
+        buffer[i] = (delta >> (8 * i)) & 0xFF;
+    buffer[4] = (uint16_t)value & 0xFF;
+    buffer[5] = (uint16_t)value >> 8;
+    buffer[6] = type;
+    buffer[7] = number;
+}
+
+inline void decodeRecord(const char *buffer, uint32_t &delta, struct js_event &js)
+{
+    delta = 0;
+    for (int i = 0; i < 4; i++)
+        delta |= (uint32_t)(uint8_t)buffer[i] << (8 * i);
+
+    js.value = (int16_t)((uint8_t)buffer[4] | (uint8_t)buffer[5] << 8);
+    js.type = buffer[6];
+    js.number = buffer[7];
+}
+
+} // namespace JoystickLog
+
+} // namespace Politocean
+
+#endif //JOYSTICK_LOG_H
@@ -0,0 +1,341 @@
+#include <JoystickManager.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <cerrno>
+#include <cctype>
+#include <algorithm>
+#include <mqttLogger.h>
+
+#include <PolitoceanExceptions.hpp>
+
+namespace Politocean
+{
+
+const std::string JoystickManager::DFLT_DIRECTORY = "/dev/input";
+const std::string JoystickManager::DFLT_PREFIX = "js";
+
+static const uint32_t WATCH_MASK = IN_CREATE | IN_ATTRIB | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM;
+
+JoystickManager::~JoystickManager()
+{
+    stop();
+}
+
+void JoystickManager::onAttach(handler_t handler)
+{
+    onAttach_ = handler;
+}
+
+void JoystickManager::onDetach(handler_t handler)
+{
+    onDetach_ = handler;
+}
+
+void JoystickManager::start()
+{
+    if (isRunning_)
+        return;
+
+    if ((inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) == -1)
+        throw JoystickException("Cannot create joystick device watch.");
+
+    if (inotify_add_watch(inotifyFd_, directory_.c_str(), WATCH_MASK) == -1)
+    {
+        close(inotifyFd_);
+        inotifyFd_ = -1;
+        throw JoystickException("Cannot watch joystick devices in " + directory_ + ".");
+    }
+
+    if ((wakeFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1)
+    {
+        close(inotifyFd_);
+        inotifyFd_ = -1;
+        throw JoystickException("Cannot create joystick manager wake up descriptor.");
+    }
+
+    // A hang up is noticed by the reading thread of the joystick, and handled by the manager thread
+    for (Slot &slot : slots_)
+        slot.joystick.onDisconnect([this]() { wakeUp(); });
+
+    isRunning_ = true;
+    manager_ = new std::thread(&JoystickManager::managingLoop, this);
+}
+
+void JoystickManager::managingLoop()
+{
+    // The watch is already in place: a device created while scanning is caught either way
+    std::vector<std::string> names;
+
+    if (DIR *dir = opendir(directory_.c_str()))
+    {
+        while (struct dirent *entry = readdir(dir))
+            if (isJoystick(entry->d_name))
+                names.push_back(entry->d_name);
+        closedir(dir);
+    }
+
+    std::sort(names.begin(), names.end());
+    for (const std::string &name : names)
+        attach(name);
+
+    struct pollfd fds[2];
+
+    fds[0].fd = wakeFd_;
+    fds[0].events = POLLIN;
+    fds[1].fd = inotifyFd_;
+    fds[1].events = POLLIN;
+
+    while (isRunning_)
+    {
+        // Nothing to retry, nothing to do until a device changes
+        if (poll(fds, 2, retryTimeout()) == -1)
+        {
+            if (errno == EINTR)
+                continue;
+
+            mqttLogger::getInstance(LIB_TAG).log(logger::ERROR, "Polling joystick devices failed.");
+            break;
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            uint64_t count;
+            while (read(wakeFd_, &count, sizeof(count)) > 0)
+                ;
+        }
+
+        if (!isRunning_)
+            break;
+
+        if (fds[1].revents & POLLIN)
+            handleEvents();
+
+        for (Slot &slot : slots_)
+        {
+            if (!slot.isAttached || slot.joystick.isConnected())
+                continue;
+
+            std::string device = slot.joystick.getDevice();
+
+            mqttLogger::getInstance(LIB_TAG).log(logger::WARNING, "Joystick " + device + " hung up.");
+            detach(slot);
+            scheduleRetry(device.substr(directory_.size() + 1));
+        }
+
+        if (!retries_.empty() && std::chrono::steady_clock::now() >= retryAt_)
+            retry();
+    }
+
+    for (Slot &slot : slots_)
+        if (slot.isAttached)
+            detach(slot);
+}
+
+void JoystickManager::handleEvents()
+{
+    alignas(struct inotify_event) char buffer[4096];
+    ssize_t num_bytes;
+
+    while ((num_bytes = read(inotifyFd_, buffer, sizeof(buffer))) > 0)
+    {
+        for (char *p = buffer; p < buffer + num_bytes;)
+        {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_IGNORED)
+            {
+                mqttLogger::getInstance(LIB_TAG).log(logger::ERROR, directory_ + " is not watched anymore.");
+                continue;
+            }
+
+            if (event->len == 0 || !isJoystick(event->name))
+                continue;
+
+            std::string name = event->name;
+            Slot *slot = findSlot(directory_ + "/" + name);
+
+            if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+            {
+                if (slot != nullptr)
+                    detach(*slot);
+                forgetRetry(name);
+            }
+            // udev creates the node before giving it its permissions: a failed attach is retried on IN_ATTRIB
+            else if (slot == nullptr && attach(name))
+                forgetRetry(name);
+        }
+    }
+}
+
+void JoystickManager::wakeUp()
+{
+    uint64_t one = 1;
+    if (write(wakeFd_, &one, sizeof(one)) == -1 && errno != EAGAIN)
+        mqttLogger::getInstance(LIB_TAG).log(logger::ERROR, "Cannot wake up joystick manager.");
+}
+
+void JoystickManager::scheduleRetry(const std::string &name)
+{
+    if (std::find(retries_.begin(), retries_.end(), name) != retries_.end())
+        return;
+
+    if (retries_.empty())
+    {
+        backoff_.reset();
+        retryAt_ = std::chrono::steady_clock::now() + backoff_.next();
+    }
+
+    retries_.push_back(name);
+}
+
+void JoystickManager::forgetRetry(const std::string &name)
+{
+    retries_.erase(std::remove(retries_.begin(), retries_.end(), name), retries_.end());
+}
+
+void JoystickManager::retry()
+{
+    std::vector<std::string> names;
+    names.swap(retries_);
+
+    for (const std::string &name : names)
+        if (!attach(name))
+            retries_.push_back(name);
+
+    if (!retries_.empty())
+        retryAt_ = std::chrono::steady_clock::now() + backoff_.next();
+}
+
+int JoystickManager::retryTimeout()
+{
+    using namespace std::chrono;
+
+    if (retries_.empty())
+        return -1;
+
+    return std::max<int>(0, duration_cast<milliseconds>(retryAt_ - steady_clock::now()).count() + 1);
+}
+
+bool JoystickManager::isJoystick(const std::string &name)
+{
+    if (name.size() <= prefix_.size() || name.compare(0, prefix_.size(), prefix_) != 0)
+        return false;
+
+    return std::all_of(name.begin() + prefix_.size(), name.end(), [](char c) { return std::isdigit((unsigned char)c); });
+}
+
+JoystickManager::Slot *JoystickManager::findSlot(const std::string &device)
+{
+    for (Slot &slot : slots_)
+        if (slot.isAttached && slot.joystick.getDevice() == device)
+            return &slot;
+
+    return nullptr;
+}
+
+bool JoystickManager::attach(const std::string &name)
+{
+    std::string device = directory_ + "/" + name;
+
+    Slot *free = nullptr;
+    for (Slot &slot : slots_)
+    {
+        if (!slot.isAttached)
+        {
+            free = &slot;
+            break;
+        }
+    }
+
+    if (free == nullptr)
+    {
+        mqttLogger::getInstance(LIB_TAG).log(logger::WARNING, "Too many joysticks, " + device + " ignored.");
+        return true;
+    }
+
+    // A slot keeps whatever its previous device left behind, e.g. presses never taken
+    free->joystick.reset();
+    free->joystick.setDevice(device);
+
+    try
+    {
+        free->joystick.connect();
+    }
+    catch (const JoystickException &e)
+    {
+        mqttLogger::getInstance(LIB_TAG).log(logger::INFO, "Joystick " + device + " not ready yet.");
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free->isAttached = true;
+    }
+
+    mqttLogger::getInstance(LIB_TAG).log(logger::INFO, "Joystick " + device + " attached.");
+
+    if (onAttach_)
+        onAttach_(free->joystick);
+
+    return true;
+}
+
+void JoystickManager::detach(Slot &slot)
+{
+    slot.joystick.stopReading();
+
+    if (onDetach_)
+        onDetach_(slot.joystick);
+
+    slot.joystick.disconnect();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slot.isAttached = false;
+    }
+
+    mqttLogger::getInstance(LIB_TAG).log(logger::INFO, "Joystick " + slot.joystick.getDevice() + " detached.");
+}
+
+void JoystickManager::stop()
+{
+    if (!isRunning_)
+        return;
+
+    isRunning_ = false;
+    wakeUp();
+
+    // The manager thread detaches every joystick before leaving
+    manager_->join();
+    delete manager_;
+    manager_ = nullptr;
+
+    close(inotifyFd_);
+    close(wakeFd_);
+    inotifyFd_ = wakeFd_ = -1;
+
+    retries_.clear();
+}
+
+std::vector<std::string> JoystickManager::getDevices()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<std::string> devices;
+    for (Slot &slot : slots_)
+        if (slot.isAttached)
+            devices.push_back(slot.joystick.getDevice());
+
+    return devices;
+}
+
+bool JoystickManager::isRunning()
+{
+    return isRunning_;
+}
+
+} // namespace Politocean
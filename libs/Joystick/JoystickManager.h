@@ -0,0 +1,119 @@
+#ifndef JOYSTICK_MANAGER_H
+#define JOYSTICK_MANAGER_H
+
+#include "Joystick.h"
+#include "Backoff.h"
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <functional>
+
+namespace Politocean
+{
+
+/**
+ * Attaches every joystick appearing in a directory, /dev/input by default, and releases it when it goes away.
+ * The directory is watched with inotify, so plugging and unplugging is noticed as it happens:
+ * a new device node is connected as soon as it is created, or as soon as udev makes it readable,
+ * and detached as soon as it is removed.
+ * Each device is a @Joystick of its own, with its own reading thread and event stream.
+ * A joystick which hangs up while its node is still there is detached and attached again,
+ * with an exponential backoff between the attempts.
+ */
+class JoystickManager
+{
+public:
+    typedef std::function<void(Joystick &joystick)> handler_t;
+
+    static const std::string DFLT_DIRECTORY;
+    static const std::string DFLT_PREFIX;
+
+    // Controllers attached at once, e.g. a pilot stick and a co-pilot arm controller
+    static const int MAX_DEVICES = 4;
+
+private:
+    const std::string LIB_TAG = "JoystickManager";
+
+    std::string directory_, prefix_;
+
+    /**
+     * Joysticks live in place in their slots: they are reused, never allocated.
+     * @isAttached is written by the manager thread only, under @mutex_.
+     */
+    struct Slot
+    {
+        Joystick joystick;
+        bool isAttached = false;
+    };
+
+    Slot slots_[MAX_DEVICES];
+
+    handler_t onAttach_, onDetach_;
+
+    /**
+     * @inotifyFd_ watches @directory_, @wakeFd_ is written to stop the manager thread
+     * or to let it know that a joystick hung up.
+     */
+    int inotifyFd_, wakeFd_;
+
+    // Names of the devices which hung up and are waiting for their next attempt, at @retryAt_
+    std::vector<std::string> retries_;
+    std::chrono::steady_clock::time_point retryAt_;
+    Backoff backoff_;
+
+    std::atomic<bool> isRunning_;
+    std::thread *manager_;
+
+    std::mutex mutex_;
+
+    void managingLoop();
+    void handleEvents();
+    void wakeUp();
+
+    void scheduleRetry(const std::string &name);
+    void forgetRetry(const std::string &name);
+    void retry();
+    int retryTimeout();
+
+    bool isJoystick(const std::string &name);
+    Slot *findSlot(const std::string &device);
+
+    // They run on the manager thread. attach() returns false if the device is worth another attempt later.
+    bool attach(const std::string &name);
+    void detach(Slot &slot);
+
+public:
+    JoystickManager(const std::string &directory = DFLT_DIRECTORY, const std::string &prefix = DFLT_PREFIX)
+        : directory_(directory), prefix_(prefix), inotifyFd_(-1), wakeFd_(-1), isRunning_(false), manager_(nullptr) {}
+    ~JoystickManager();
+
+    /**
+     * @onAttach is called with every joystick just connected, before it starts reading,
+     * @onDetach with every joystick about to be released, once it stopped reading.
+     * Both run on the manager thread and must be set before start().
+     */
+    void onAttach(handler_t handler);
+    void onDetach(handler_t handler);
+
+    /**
+     * Attaches the joysticks already there and starts watching for new ones.
+     * It throws a @JoystickException if the directory cannot be watched.
+     */
+    void start();
+
+    // Stops watching and detaches every joystick
+    void stop();
+
+    // Device paths of the joysticks attached
+    std::vector<std::string> getDevices();
+
+    bool isRunning();
+};
+
+} // namespace Politocean
+
+#endif //JOYSTICK_MANAGER_H
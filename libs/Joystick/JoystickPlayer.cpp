@@ -0,0 +1,197 @@
+#include <JoystickPlayer.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <mqttLogger.h>
+
+#include <PolitoceanExceptions.hpp>
+
+namespace Politocean
+{
+
+JoystickPlayer::JoystickPlayer(const std::string &path, const std::string &device)
+    : fd_(-1), isPlaying_(false), player_(nullptr)
+{
+    load(path);
+
+    if (!device.empty())
+    {
+        createDevice(device);
+        return;
+    }
+
+    char directory[] = "/tmp/politocean_replay_XXXXXX";
+    if (mkdtemp(directory) == nullptr)
+        throw JoystickException("Cannot create a directory for the joystick replay device.");
+
+    directory_ = directory;
+
+    try
+    {
+        createDevice(directory_ + "/js");
+    }
+    catch (const JoystickException &)
+    {
+        rmdir(directory_.c_str());
+        throw;
+    }
+}
+
+JoystickPlayer::~JoystickPlayer()
+{
+    stop();
+
+    if (fd_ != -1)
+        close(fd_);
+    unlink(device_.c_str());
+
+    if (!directory_.empty())
+        rmdir(directory_.c_str());
+}
+
+void JoystickPlayer::createDevice(const std::string &device)
+{
+    // Whatever is already at @device is not ours to replace
+    if (mkfifo(device.c_str(), 0600) == -1)
+        throw JoystickException("Cannot create joystick replay device " + device + ".");
+
+    // Opened read-write, so that the joystick open does not block waiting for a writer
+    if ((fd_ = open(device.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC)) == -1)
+    {
+        unlink(device.c_str());
+        throw JoystickException("Cannot open joystick replay device " + device + ".");
+    }
+
+    device_ = device;
+}
+
+void JoystickPlayer::load(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw JoystickException("Cannot open joystick log " + path + ".");
+
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (data.size() < JoystickLog::HEADER_SIZE || !JoystickLog::isHeader(data.data()))
+        throw JoystickException(path + " is not a joystick log.");
+
+    uint64_t time = 0;
+
+    for (std::size_t offset = JoystickLog::HEADER_SIZE; offset + JoystickLog::RECORD_SIZE <= data.size(); offset += JoystickLog::RECORD_SIZE)
+    {
+        uint32_t delta;
+        struct js_event js;
+
+        JoystickLog::decodeRecord(data.data() + offset, delta, js);
+        time += delta * 1000ULL;
+
+        if (js.type == JoystickLog::WAIT)
+            continue;
+
+        if (steps_.empty() || steps_.back().time != time)
+            steps_.push_back(Step{time, {}});
+
+        steps_.back().events.push_back(js);
+    }
+}
+
+void JoystickPlayer::play(double speed)
+{
+    if (isPlaying_ || fd_ == -1)
+        return;
+
+    isPlaying_ = true;
+    player_ = new std::thread(&JoystickPlayer::playingLoop, this, speed);
+}
+
+void JoystickPlayer::playingLoop(double speed)
+{
+    using std::chrono::steady_clock;
+
+    steady_clock::time_point start = steady_clock::now();
+
+    for (Step &step : steps_)
+    {
+        if (speed > 0)
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds((uint64_t)(step.time / speed)));
+
+        uint32_t now = std::chrono::duration_cast<std::chrono::milliseconds>(steady_clock::now().time_since_epoch()).count();
+        for (struct js_event &js : step.events)
+            js.time = now;
+
+        const char *data = (const char *)step.events.data();
+        std::size_t size = step.events.size() * sizeof(struct js_event), written = 0;
+
+        // The FIFO fills up when the joystick falls behind: wait for it, but keep an eye on stop()
+        while (written < size && isPlaying_)
+        {
+            ssize_t num_bytes = write(fd_, data + written, size - written);
+
+            if (num_bytes > 0)
+                written += num_bytes;
+            else if (num_bytes == -1 && errno == EAGAIN)
+            {
+                struct pollfd pfd = {fd_, POLLOUT, 0};
+                poll(&pfd, 1, 100);
+            }
+            else if (num_bytes == -1 && errno != EINTR)
+            {
+                mqttLogger::getInstance(LIB_TAG).log(logger::ERROR, "Cannot write to joystick replay device.");
+                isPlaying_ = false;
+            }
+        }
+
+        if (!isPlaying_)
+            break;
+    }
+
+    // The last writer leaves: the joystick reads what is left, then sees the device hang up
+    close(fd_);
+    fd_ = -1;
+
+    isPlaying_ = false;
+}
+
+void JoystickPlayer::wait()
+{
+    if (player_ == nullptr)
+        return;
+
+    player_->join();
+    delete player_;
+    player_ = nullptr;
+}
+
+void JoystickPlayer::stop()
+{
+    isPlaying_ = false;
+    wait();
+}
+
+const std::string &JoystickPlayer::getDevice()
+{
+    return device_;
+}
+
+bool JoystickPlayer::isPlaying()
+{
+    return isPlaying_;
+}
+
+std::size_t JoystickPlayer::getEvents()
+{
+    std::size_t events = 0;
+    for (const Step &step : steps_)
+        events += step.events.size();
+
+    return events;
+}
+
+} // namespace Politocean
@@ -0,0 +1,77 @@
+#ifndef JOYSTICK_PLAYER_H
+#define JOYSTICK_PLAYER_H
+
+#include <linux/joystick.h>
+
+#include "JoystickLog.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+
+namespace Politocean
+{
+
+/**
+ * Plays a @JoystickLog back through a FIFO which a @Joystick opens as its device,
+ * so that a recorded session goes through the very same reading, listener and talker path.
+ * The whole log is loaded up front: playing it does no file I/O but the FIFO writes.
+ * When the log is over the FIFO hangs up, and the joystick sees it as a disconnection.
+ */
+class JoystickPlayer
+{
+    const std::string LIB_TAG = "JoystickPlayer";
+
+    struct Step
+    {
+        // Nanoseconds since the beginning of the log
+        uint64_t time;
+        std::vector<struct js_event> events;
+    };
+
+    std::string device_;
+    int fd_;
+
+    // Private directory holding @device_, if the player chose it, to be removed with it
+    std::string directory_;
+
+    // Events stamped with the same time are replayed with a single write
+    std::vector<Step> steps_;
+
+    std::atomic<bool> isPlaying_;
+    std::thread *player_;
+
+    void load(const std::string &path);
+    void createDevice(const std::string &device);
+    void playingLoop(double speed);
+
+public:
+    /**
+     * Loads the log at @path and creates the @device FIFO, which must not exist yet.
+     * Without a @device, the FIFO goes in a private directory of its own under /tmp.
+     * Either is removed with the player.
+     * It throws a @JoystickException if the log is not valid or the FIFO cannot be created.
+     */
+    JoystickPlayer(const std::string &path, const std::string &device = "");
+    ~JoystickPlayer();
+
+    // The device to give to the @Joystick
+    const std::string &getDevice();
+
+    /**
+     * Starts playing the log at @speed times the original pace, or as fast as the joystick reads it if @speed is 0.
+     */
+    void play(double speed = 1);
+    // Blocks until the whole log has been played
+    void wait();
+    void stop();
+
+    bool isPlaying();
+    std::size_t getEvents();
+};
+
+} // namespace Politocean
+
+#endif //JOYSTICK_PLAYER_H
@@ -0,0 +1,156 @@
+#include <JoystickRecorder.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <mqttLogger.h>
+
+#include <PolitoceanExceptions.hpp>
+
+namespace Politocean
+{
+
+const std::size_t JoystickRecorder::QUEUE_SIZE;
+const int JoystickRecorder::WRITE_PERIOD;
+
+JoystickRecorder::~JoystickRecorder()
+{
+    stop();
+}
+
+void JoystickRecorder::start(const std::string &path)
+{
+    if (isRecording_)
+        return;
+
+    if ((fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644)) == -1)
+        throw JoystickException("Cannot open joystick log " + path + ".");
+
+    char header[JoystickLog::HEADER_SIZE];
+    JoystickLog::encodeHeader(header);
+
+    if (write(fd_, header, sizeof(header)) != sizeof(header))
+    {
+        close(fd_);
+        fd_ = -1;
+        throw JoystickException("Cannot write joystick log " + path + ".");
+    }
+
+    isFirstRecord_ = true;
+    isRecording_ = true;
+    writer_ = new std::thread(&JoystickRecorder::writingLoop, this);
+}
+
+void JoystickRecorder::record(const struct js_event *events, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (!records_.push(events[i]))
+            dropped_++;
+    }
+}
+
+void JoystickRecorder::writingLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (isRecording_)
+    {
+        cv_.wait_for(lock, std::chrono::milliseconds(WRITE_PERIOD), [this]() { return !isRecording_; });
+
+        flush();
+    }
+}
+
+void JoystickRecorder::flush()
+{
+    std::size_t size = 0;
+    struct js_event event;
+
+    auto writeBuffer = [&]() {
+        std::size_t written = 0;
+
+        while (written < size)
+        {
+            ssize_t num_bytes = write(fd_, buffer_ + written, size - written);
+            if (num_bytes == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                mqttLogger::getInstance(LIB_TAG).log(logger::ERROR, "Cannot write joystick log.");
+                break;
+            }
+            written += num_bytes;
+        }
+
+        size = 0;
+    };
+
+    auto append = [&](uint32_t delta, uint8_t type, uint8_t number, int16_t value) {
+        if (size == sizeof(buffer_))
+            writeBuffer();
+
+        JoystickLog::encodeRecord(buffer_ + size, delta, type, number, value);
+        size += JoystickLog::RECORD_SIZE;
+    };
+
+    while (records_.pop(event))
+    {
+        if (isFirstRecord_)
+        {
+            lastTime_ = event.time;
+            isFirstRecord_ = false;
+        }
+
+        // The kernel time is in milliseconds and wraps around every 49 days: the difference does not mind
+        uint64_t delta = (uint32_t)(event.time - lastTime_) * 1000ULL;
+        lastTime_ = event.time;
+
+        for (; delta > JoystickLog::MAX_DELTA; delta -= JoystickLog::MAX_DELTA)
+            append(JoystickLog::MAX_DELTA, JoystickLog::WAIT, 0, 0);
+
+        append(delta, event.type, event.number, event.value);
+        recorded_++;
+    }
+
+    if (size > 0)
+        writeBuffer();
+}
+
+void JoystickRecorder::stop()
+{
+    if (writer_ == nullptr)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        isRecording_ = false;
+    }
+    cv_.notify_all();
+
+    // The writer flushes once more before leaving
+    writer_->join();
+    delete writer_;
+    writer_ = nullptr;
+
+    close(fd_);
+    fd_ = -1;
+}
+
+bool JoystickRecorder::isRecording()
+{
+    return isRecording_;
+}
+
+unsigned long JoystickRecorder::getRecorded()
+{
+    return recorded_;
+}
+
+unsigned long JoystickRecorder::getDropped()
+{
+    return dropped_;
+}
+
+} // namespace Politocean
@@ -0,0 +1,82 @@
+#ifndef JOYSTICK_RECORDER_H
+#define JOYSTICK_RECORDER_H
+
+#include <linux/joystick.h>
+
+#include "RingBuffer.h"
+#include "JoystickLog.h"
+
+#include <string>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+namespace Politocean
+{
+
+/**
+ * Records every raw js_event a @Joystick reads into a @JoystickLog file.
+ * The reading thread only pushes into a preallocated lock-free queue, a background
+ * thread encodes the queue every WRITE_PERIOD milliseconds and appends it with a single write.
+ * Records are timed by the kernel timestamp of their event, not by when the joystick got to read them.
+ */
+class JoystickRecorder
+{
+    const std::string LIB_TAG = "JoystickRecorder";
+
+    static const std::size_t QUEUE_SIZE = 8192;
+    static const int WRITE_PERIOD = 100;
+
+    int fd_;
+
+    /**
+     * @records_ hands the events over from the joystick thread to the writer.
+     * @buffer_ is where the writer encodes them, large enough for a whole queue.
+     */
+    RingBuffer<struct js_event, QUEUE_SIZE> records_;
+    char buffer_[QUEUE_SIZE * JoystickLog::RECORD_SIZE];
+
+    // js_event time of the last record written, in milliseconds
+    uint32_t lastTime_;
+    bool isFirstRecord_;
+
+    std::atomic<unsigned long> recorded_, dropped_;
+
+    std::atomic<bool> isRecording_;
+    std::thread *writer_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    void writingLoop();
+    void flush();
+
+public:
+    JoystickRecorder() : fd_(-1), lastTime_(0), isFirstRecord_(true), recorded_(0), dropped_(0), isRecording_(false), writer_(nullptr) {}
+    ~JoystickRecorder();
+
+    /**
+     * Creates or truncates the log at @path and starts the writer.
+     * It throws a @JoystickException if the file cannot be written.
+     */
+    void start(const std::string &path);
+
+    /**
+     * Queues @count events read at once. It is called by the joystick reading thread only,
+     * and never blocks: events which do not fit in the queue are counted as dropped.
+     */
+    void record(const struct js_event *events, int count);
+
+    // Writes whatever is still queued and closes the log
+    void stop();
+
+    bool isRecording();
+
+    unsigned long getRecorded();
+    unsigned long getDropped();
+};
+
+} // namespace Politocean
+
+#endif //JOYSTICK_RECORDER_H
@@ -0,0 +1,80 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace Politocean
+{
+
+/**
+ * Bounded lock-free queue for exactly one producer thread and one consumer thread.
+ * @N must be a power of two.
+ */
+template <class T, std::size_t N>
+class RingBuffer
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0, "RingBuffer size must be a power of two.");
+
+    T buffer_[N];
+
+    // @head_ is written by the consumer only, @tail_ by the producer only
+    alignas(64) std::atomic<std::size_t> head_;
+    alignas(64) std::atomic<std::size_t> tail_;
+
+public:
+    RingBuffer() : head_(0), tail_(0) {}
+
+    RingBuffer(const RingBuffer &) = delete;
+    RingBuffer &operator=(const RingBuffer &) = delete;
+
+    /**
+     * Appends @item to the queue. Producer side only.
+     * Returns false, leaving the queue untouched, if it is full.
+     */
+    bool push(const T &item)
+    {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+
+        if (tail - head_.load(std::memory_order_acquire) == N)
+            return false;
+
+        buffer_[tail & (N - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * Moves the oldest element into @item. Consumer side only.
+     * Returns false if the queue is empty.
+     */
+    bool pop(T &item)
+    {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+
+        if (head == tail_.load(std::memory_order_acquire))
+            return false;
+
+        item = buffer_[head & (N - 1)];
+        head_.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool empty() const
+    {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    std::size_t size() const
+    {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    static constexpr std::size_t capacity() { return N; }
+};
+
+} // namespace Politocean
+
+#endif //RING_BUFFER_H
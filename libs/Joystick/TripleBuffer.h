@@ -0,0 +1,68 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+namespace Politocean
+{
+
+/**
+ * Wait-free snapshot handoff between one writer thread and one reader thread.
+ * The writer fills back() and calls publish(), the reader calls read() and always gets
+ * the latest complete value without ever blocking the writer.
+ */
+template <class T>
+class TripleBuffer
+{
+    static const unsigned int INDEX = 0x3;
+    static const unsigned int DIRTY = 0x4;
+
+    T buffers_[3];
+
+    // @middle_ is the index of the buffer being exchanged, plus DIRTY if the writer published it
+    std::atomic<unsigned int> middle_;
+    unsigned int front_, back_;
+
+public:
+    TripleBuffer(const T &value = T()) : buffers_{value, value, value}, middle_(1), front_(0), back_(2) {}
+
+    TripleBuffer(const TripleBuffer &) = delete;
+    TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+    // Writer side: the buffer to fill before calling publish()
+    T &back()
+    {
+        return buffers_[back_];
+    }
+
+    // Writer side: makes back() visible to the reader and takes a free buffer for the next value
+    void publish()
+    {
+        back_ = middle_.exchange(back_ | DIRTY, std::memory_order_acq_rel) & INDEX;
+    }
+
+    void write(const T &value)
+    {
+        back() = value;
+        publish();
+    }
+
+    // Reader side: returns true if a new value has been published since the last read()
+    bool isUpdated() const
+    {
+        return middle_.load(std::memory_order_acquire) & DIRTY;
+    }
+
+    // Reader side: returns the latest published value
+    const T &read()
+    {
+        if (isUpdated())
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+
+        return buffers_[front_];
+    }
+};
+
+} // namespace Politocean
+
+#endif //TRIPLE_BUFFER_H
@@ -1,7 +1,10 @@
 #include <iostream>
 #include <string.h>
+#include <errno.h>
+#include <poll.h>
 
-#include "Serial.hpp"
+#include "Serial.h"
+#include "Termios2.h"
 
 namespace Unix
 {
@@ -12,6 +15,15 @@ namespace Unix
 void Serial::setBaudRate(BaudRate baudRate)
 {
     baudRate_ = baudRate;
+
+    if (state_ == State::OPEN)
+        tty_.configure(fd_, baudRate_, customBaudRate_);
+}
+
+void Serial::setBaudRate(unsigned int customBaudRate)
+{
+    customBaudRate_ = customBaudRate;
+    setBaudRate(BaudRate::CUSTOM);
 }
 
 void Serial::open()
@@ -24,55 +36,180 @@ void Serial::open()
     if ((fd_ = Unix::open(device_.c_str(), O_RDWR)) < 0)
         throw SerialException("Device \"" + device_ + "\" cannot be opened.");
 
-    TTY::configure(fd_);
+    tty_.configure(fd_, baudRate_, customBaudRate_);
+
+    state_ = State::OPEN;
 }
 
-int Serial::read(std::string &str)
+int Serial::fill()
 {
-    char readBuffer[256];
-    memset(&readBuffer, '\0', sizeof(readBuffer));
+    // Make room at the end of the buffer for the incoming bytes
+    if (begin_ > 0)
+    {
+        memmove(buffer_, buffer_ + begin_, end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+    }
+
+    int num_bytes = Unix::read(fd_, buffer_ + end_, BUFFER_SIZE - end_);
+    readCalls_++;
 
-    int num_bytes = Unix::read(fd_, &readBuffer, sizeof(readBuffer));
+    if (num_bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
 
     if (num_bytes < 0)
         throw SerialException("An error occurred reading serial.");
 
-    if (num_bytes > 0)
-        str = std::string(readBuffer, num_bytes);
+    isEof_ = num_bytes == 0;
+    end_ += num_bytes;
 
     return num_bytes;
 }
 
-int Serial::readLine(std::string &str)
+int Serial::read(std::string &str)
 {
-    char readBuffer;
-    memset(&readBuffer, '\0', sizeof(readBuffer));
+    // Bytes already buffered by readLine come first
+    if (begin_ == end_ && fill() == 0)
+        return 0;
+
+    int num_bytes = end_ - begin_;
 
-    std::string readLine;
+    str.assign(buffer_ + begin_, num_bytes);
+    begin_ = end_ = 0;
+
+    return num_bytes;
+}
+
+int Serial::readLine(std::string &str)
+{
+    SerialLine line;
 
-    int num_line = 0;
+    int num_line;
+    bool isWoken = false;
 
-    while (readBuffer != '\n')
+    for (;;)
     {
-        int num_bytes = Unix::read(fd_, &readBuffer, sizeof(char));
+        std::size_t buffered = end_ - begin_;
 
-        if (num_bytes < 0)
-            throw SerialException("An error occurred reading serial.");
+        if ((num_line = readLine(line)) > 0)
+            break;
 
-        readLine += readBuffer;
-        num_line++;
+        // Woken up for bytes which never came: nothing will, the other end is gone
+        if (isWoken && isEof_ && end_ - begin_ == buffered)
+            throw SerialException("Serial port reached end of file.");
+
+        waitReadable();
+        isWoken = true;
     }
 
-    str = readLine;
+    str.assign(line.data, line.size);
 
     return num_line;
 }
 
-termios TTY::tty_ = {0};
+void Serial::waitReadable()
+{
+    struct pollfd pfd;
+    pfd.fd = fd_;
+    pfd.events = POLLIN;
+
+    int ready;
+    while ((ready = poll(&pfd, 1, -1)) < 0 && errno == EINTR)
+        ;
+
+    if (ready < 0 || (pfd.revents & (POLLERR | POLLNVAL)))
+        throw SerialException("An error occurred waiting for serial.");
+
+    // A hung up port with nothing left to read
+    if ((pfd.revents & POLLHUP) && !(pfd.revents & POLLIN))
+        throw SerialException("Serial port hung up.");
+}
+
+int Serial::readLine(SerialLine &line)
+{
+    return readUntil(line, '\n');
+}
+
+int Serial::readUntil(SerialLine &frame, char delimiter)
+{
+    std::size_t scanned = begin_;
+
+    for (;;)
+    {
+        const char *end = static_cast<const char *>(memchr(buffer_ + scanned, delimiter, end_ - scanned));
+
+        if (end != nullptr || end_ - begin_ == BUFFER_SIZE)
+        {
+            std::size_t size = end != nullptr ? end - (buffer_ + begin_) + 1 : BUFFER_SIZE;
+
+            frame.data = buffer_ + begin_;
+            frame.size = size;
+            begin_ += size;
+
+            return size;
+        }
+
+        // Only the new bytes need to be scanned next time
+        scanned = end_ - begin_;
+
+        if (fill() == 0)
+            return 0;
+    }
+}
+
+int Serial::write(const char *data, std::size_t size)
+{
+    int num_bytes = Unix::write(fd_, data, size);
+
+    if (num_bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+
+    if (num_bytes < 0)
+        throw SerialException("An error occurred writing serial.");
+
+    return num_bytes;
+}
+
+int Serial::write(const std::string &str)
+{
+    return write(str.data(), str.size());
+}
+
+int Serial::getFd()
+{
+    return fd_;
+}
+
+unsigned long Serial::getReadCalls()
+{
+    return readCalls_;
+}
+
+bool Serial::isOpen()
+{
+    return state_ == State::OPEN;
+}
+
+void Serial::setBlocking(bool isBlocking)
+{
+    int flags = Unix::fcntl(fd_, F_GETFL);
+
+    if (flags < 0 || Unix::fcntl(fd_, F_SETFL, isBlocking ? flags & ~O_NONBLOCK : flags | O_NONBLOCK) < 0)
+        throw SerialException("Cannot change serial blocking mode.");
+}
 
 void Serial::close()
 {
-    if (Unix::close(fd_) < 0)
+    if (state_ == State::CLOSE)
+        return;
+
+    begin_ = end_ = 0;
+    state_ = State::CLOSE;
+
+    int fd = fd_;
+    fd_ = -1;
+
+    if (Unix::close(fd) < 0)
         throw SerialException("Cannot close serial port.");
 }
 
@@ -84,7 +221,39 @@ void TTY::get(int fd)
         throw SerialException("An error occurred retrieving serial port attributes.");
 }
 
-void TTY::configure(int fd)
+speed_t TTY::toSpeed(BaudRate baudRate)
+{
+    switch (baudRate)
+    {
+    case BaudRate::B_9600:
+        return B9600;
+    case BaudRate::B_19200:
+        return B19200;
+    case BaudRate::B_38400:
+        return B38400;
+    case BaudRate::B_57600:
+        return B57600;
+    case BaudRate::B_115200:
+        return B115200;
+    case BaudRate::B_230400:
+        return B230400;
+    case BaudRate::B_460800:
+        return B460800;
+    case BaudRate::B_500000:
+        return B500000;
+    case BaudRate::B_921600:
+        return B921600;
+    case BaudRate::B_1000000:
+        return B1000000;
+    case BaudRate::B_2000000:
+        return B2000000;
+    default:
+        // CUSTOM: a placeholder, the real rate is set through termios2
+        return B38400;
+    }
+}
+
+void TTY::configure(int fd, BaudRate baudRate, unsigned int customBaudRate)
 {
     get(fd);
 
@@ -110,11 +279,14 @@ void TTY::configure(int fd)
     tty_.c_cc[VTIME] = 10; // Wait for up to 1s (10 deciseconds), returning as soon as any data is received.
     tty_.c_cc[VMIN] = 0;
 
-    // Set in/out baud rate to be 9600
-    cfsetispeed(&tty_, B9600);
-    cfsetospeed(&tty_, B9600);
+    cfsetispeed(&tty_, toSpeed(baudRate));
+    cfsetospeed(&tty_, toSpeed(baudRate));
 
     set(fd);
+
+    // Rates without a Bxxx constant need termios2 and BOTHER
+    if (baudRate == BaudRate::CUSTOM && !Termios2::setBaudRate(fd, customBaudRate))
+        throw SerialException("Cannot set baud rate " + std::to_string(customBaudRate) + ".");
 }
 
 void TTY::set(int fd)
@@ -1,4 +1,8 @@
+#ifndef SERIAL_H
+#define SERIAL_H
+
 #include <string>
+#include <cstddef>
 #include <exception>
 
 #include <string.h>
@@ -7,9 +11,16 @@
 enum class BaudRate
 {
     B_9600,
+    B_19200,
     B_38400,
     B_57600,
     B_115200,
+    B_230400,
+    B_460800,
+    B_500000,
+    B_921600,
+    B_1000000,
+    B_2000000,
     CUSTOM
 };
 
@@ -19,15 +30,38 @@ enum class State
     CLOSE
 };
 
+/**
+ * Attributes of a single serial port.
+ */
 class TTY
 {
-    static struct termios tty_;
+    struct termios tty_;
+
+    void get(int fd);
+    void set(int fd);
 
-    static void get(int fd);
-    static void set(int fd);
+    static speed_t toSpeed(BaudRate baudRate);
 
 public:
-    static void configure(int fd);
+    TTY() : tty_() {}
+
+    /**
+     * Sets the port in raw 8N1 mode at @baudRate.
+     * @customBaudRate is the rate in bit/s used when @baudRate is BaudRate::CUSTOM.
+     */
+    void configure(int fd, BaudRate baudRate, unsigned int customBaudRate);
+};
+
+/**
+ * A line inside the Serial read buffer, '\n' included.
+ * It is only valid until the next read on the same Serial.
+ */
+struct SerialLine
+{
+    const char *data;
+    std::size_t size;
+
+    std::string str() const { return std::string(data, size); }
 };
 
 class Serial
@@ -36,12 +70,39 @@ class Serial
 
     std::string device_;
     BaudRate baudRate_;
+    unsigned int customBaudRate_;
     State state_;
 
+    TTY tty_;
+
+    /**
+     * @buffer_ holds bytes read from the port and not consumed yet, from @begin_ to @end_.
+     * Each read() syscall fills as much of it as the port has available.
+     */
+    static const std::size_t BUFFER_SIZE = 4096;
+    char buffer_[BUFFER_SIZE];
+    std::size_t begin_, end_;
+
+    // Number of read() syscalls made on the port
+    unsigned long readCalls_;
+
+    // Reads the available bytes after @end_. Returns 0 on timeout, end of file or, in non-blocking mode, no data.
+    int fill();
+
+    // True if the last read() returned 0, which is a timeout or an end of file: a tty cannot tell them apart
+    bool isEof_;
+
+    /**
+     * Sleeps until the port has bytes to read.
+     * It throws a @SerialException if it hangs up or fails meanwhile.
+     */
+    void waitReadable();
+
 public:
     static const BaudRate DFLT_BAUDRATE = BaudRate::B_9600;
 
-    Serial(const std::string &device, BaudRate baudRate) : fd_(-1), device_(device), baudRate_(baudRate), state_(State::CLOSE) {}
+    Serial(const std::string &device, BaudRate baudRate) : fd_(-1), device_(device), baudRate_(baudRate), customBaudRate_(0), state_(State::CLOSE), begin_(0), end_(0), readCalls_(0), isEof_(false) {}
+    Serial(const std::string &device, unsigned int customBaudRate) : Serial(device, BaudRate::CUSTOM) { customBaudRate_ = customBaudRate; }
     Serial(const std::string &device) : Serial(device, DFLT_BAUDRATE) {}
 
     ~Serial()
@@ -52,10 +113,46 @@ public:
     void open();
     void close();
 
+    int getFd();
+    bool isOpen();
+    unsigned long getReadCalls();
+
+    // In non-blocking mode reads and writes return 0 instead of waiting for the port
+    void setBlocking(bool isBlocking);
+
+    /**
+     * They apply immediately if the port is open, otherwise on open().
+     * The second one sets an arbitrary rate in bit/s (BaudRate::CUSTOM).
+     */
     void setBaudRate(BaudRate baudRate);
+    void setBaudRate(unsigned int customBaudRate);
 
     int read(std::string &str);
+
+    /**
+     * Waits for a whole line and copies it into @str, sleeping while the port is silent.
+     * Returns its length, '\n' included.
+     * It throws a @SerialException if the port hangs up or reaches end of file first.
+     */
     int readLine(std::string &str);
+
+    /**
+     * Points @line to the next line inside the read buffer, without copying it.
+     * Returns its length, '\n' included, or 0 if the port timed out before a whole line arrived:
+     * the partial line is kept for the next call.
+     * A line longer than the buffer is returned in BUFFER_SIZE chunks.
+     */
+    int readLine(SerialLine &line);
+
+    // As readLine(SerialLine &), for frames ending with @delimiter
+    int readUntil(SerialLine &frame, char delimiter);
+
+    /**
+     * Writes up to @size bytes of @data.
+     * Returns the number of bytes written, which can be less than @size in non-blocking mode.
+     */
+    int write(const char *data, std::size_t size);
+    int write(const std::string &str);
 };
 
 class SerialException : public std::exception
@@ -69,4 +166,6 @@ public:
     {
         return msg_.c_str();
     }
-};
\ No newline at end of file
+};
+
+#endif //SERIAL_H
@@ -0,0 +1,227 @@
+#include <iostream>
+
+#include "SerialEventLoop.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+SerialEventLoop::SerialEventLoop() : isRunning_(false), loopThread_(nullptr)
+{
+    if ((epollFd_ = epoll_create1(EPOLL_CLOEXEC)) < 0)
+        throw SerialException("Cannot create serial event loop.");
+
+    if ((wakeFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) < 0)
+    {
+        close(epollFd_);
+        throw SerialException("Cannot create serial event loop.");
+    }
+
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = wakeFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+}
+
+SerialEventLoop::~SerialEventLoop()
+{
+    stop();
+
+    close(wakeFd_);
+    close(epollFd_);
+}
+
+void SerialEventLoop::watch(int fd, bool isWriting, int operation)
+{
+    struct epoll_event event = {};
+    event.events = (uint32_t)EPOLLIN | (isWriting ? (uint32_t)EPOLLOUT : 0);
+    event.data.fd = fd;
+
+    if (epoll_ctl(epollFd_, operation, fd, &event) < 0)
+        throw SerialException("Cannot watch serial port.");
+}
+
+void SerialEventLoop::add(Serial &serial, callback_t callback, char delimiter)
+{
+    if (!serial.isOpen())
+        throw SerialException("Cannot serve a closed serial port.");
+
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+    int fd = serial.getFd();
+
+    serial.setBlocking(false);
+    watch(fd, false, EPOLL_CTL_ADD);
+
+    Port &port = ports_[fd];
+    port.serial = &serial;
+    port.callback = callback;
+    port.delimiter = delimiter;
+    port.outOffset = 0;
+}
+
+void SerialEventLoop::remove(Serial &serial)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+    int fd = serial.getFd();
+
+    if (ports_.erase(fd) > 0)
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+void SerialEventLoop::write(Serial &serial, const std::string &data)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+    auto it = ports_.find(serial.getFd());
+    if (it == ports_.end())
+        throw SerialException("Serial port is not served by the event loop.");
+
+    Port &port = it->second;
+    bool wasIdle = port.outQueue.empty();
+
+    port.outQueue.push_back(data);
+
+    // Fast path: nothing queued before, try to send it now
+    if (wasIdle)
+        handleWrite(port);
+
+    // epoll_ctl takes effect even while the loop thread is inside epoll_wait
+    if (!port.outQueue.empty() && wasIdle)
+        watch(it->first, true, EPOLL_CTL_MOD);
+}
+
+void SerialEventLoop::handleWrite(Port &port)
+{
+    while (!port.outQueue.empty())
+    {
+        const std::string &data = port.outQueue.front();
+
+        int num_bytes = port.serial->write(data.data() + port.outOffset, data.size() - port.outOffset);
+        if (num_bytes == 0)
+            return;
+
+        port.outOffset += num_bytes;
+        if (port.outOffset < data.size())
+            return;
+
+        port.outQueue.pop_front();
+        port.outOffset = 0;
+    }
+}
+
+void SerialEventLoop::handleRead(int fd)
+{
+    SerialLine frame;
+
+    for (;;)
+    {
+        // The port is looked up again after every callback, which may have changed the map
+        auto it = ports_.find(fd);
+        if (it == ports_.end())
+            return;
+
+        Port &port = it->second;
+        if (port.serial->readUntil(frame, port.delimiter) == 0)
+            return;
+
+        port.callback(frame);
+    }
+}
+
+void SerialEventLoop::loop()
+{
+    struct epoll_event events[MAX_EVENTS];
+
+    while (isRunning_)
+    {
+        int num_events = epoll_wait(epollFd_, events, MAX_EVENTS, -1);
+
+        if (num_events < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            std::cerr << "Serial event loop failed." << std::endl;
+            break;
+        }
+
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+        for (int i = 0; i < num_events; i++)
+        {
+            int fd = events[i].data.fd;
+
+            if (fd == wakeFd_)
+            {
+                uint64_t count;
+                while (read(wakeFd_, &count, sizeof(count)) > 0)
+                    ;
+                continue;
+            }
+
+            auto it = ports_.find(fd);
+            if (it == ports_.end())
+                continue;
+
+            try
+            {
+                if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+                    handleRead(fd);
+
+                // Whatever was left has been read, the port is gone
+                if (events[i].events & (EPOLLERR | EPOLLHUP))
+                    throw SerialException("Serial port hung up.");
+
+                it = ports_.find(fd);
+                if (it != ports_.end() && (events[i].events & EPOLLOUT))
+                {
+                    handleWrite(it->second);
+                    if (it->second.outQueue.empty())
+                        watch(fd, false, EPOLL_CTL_MOD);
+                }
+            }
+            catch (const SerialException &e)
+            {
+                // A broken port is dropped, the others keep being served
+                std::cerr << "Serial port dropped: " << e.what() << std::endl;
+
+                ports_.erase(fd);
+                epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+            }
+        }
+    }
+}
+
+void SerialEventLoop::start()
+{
+    if (isRunning_)
+        return;
+
+    isRunning_ = true;
+    loopThread_ = new std::thread(&SerialEventLoop::loop, this);
+}
+
+void SerialEventLoop::stop()
+{
+    if (!isRunning_)
+        return;
+
+    isRunning_ = false;
+
+    uint64_t one = 1;
+    if (::write(wakeFd_, &one, sizeof(one)) < 0)
+        std::cerr << "Cannot wake serial event loop up." << std::endl;
+
+    loopThread_->join();
+    delete loopThread_;
+    loopThread_ = nullptr;
+}
+
+bool SerialEventLoop::isRunning()
+{
+    return isRunning_;
+}
@@ -0,0 +1,78 @@
+#ifndef SERIAL_EVENT_LOOP_H
+#define SERIAL_EVENT_LOOP_H
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <functional>
+
+#include "Serial.h"
+
+/**
+ * Serves many Serial ports from a single thread, multiplexed over one epoll instance.
+ * Complete frames are handed to a per-port callback, writes are queued and sent
+ * as soon as each port can take them.
+ */
+class SerialEventLoop
+{
+public:
+    typedef std::function<void(const SerialLine &frame)> callback_t;
+
+private:
+    struct Port
+    {
+        Serial *serial;
+        callback_t callback;
+        char delimiter;
+
+        // @outQueue is sent in order, @outOffset bytes of its front are already written
+        std::deque<std::string> outQueue;
+        std::size_t outOffset;
+    };
+
+    int epollFd_, wakeFd_;
+
+    // Ports by file descriptor, guarded by @mutex_
+    std::map<int, Port> ports_;
+    std::recursive_mutex mutex_;
+
+    std::atomic<bool> isRunning_;
+    std::thread *loopThread_;
+
+    static const int MAX_EVENTS = 16;
+
+    void loop();
+    void handleRead(int fd);
+    void handleWrite(Port &port);
+    void watch(int fd, bool isWriting, int operation);
+
+public:
+    // It throws a @SerialException if epoll is not available
+    SerialEventLoop();
+    ~SerialEventLoop();
+
+    /**
+     * Starts serving @serial, which must be open. Each frame ending with @delimiter is passed to @callback
+     * from the loop thread, and it is only valid during the call.
+     * A callback must not remove its own port.
+     */
+    void add(Serial &serial, callback_t callback, char delimiter = '\n');
+    void remove(Serial &serial);
+
+    /**
+     * Queues @data for @serial without blocking. Bytes the port can take right away are written immediately.
+     */
+    void write(Serial &serial, const std::string &data);
+
+    // Runs the loop in its own thread
+    void start();
+    // Stops and joins the loop thread, waking it up immediately
+    void stop();
+
+    bool isRunning();
+};
+
+#endif //SERIAL_EVENT_LOOP_H
@@ -0,0 +1,24 @@
+#include "Termios2.h"
+
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+
+namespace Termios2
+{
+
+bool setBaudRate(int fd, unsigned int baudRate)
+{
+    struct termios2 tty;
+
+    if (ioctl(fd, TCGETS2, &tty) != 0)
+        return false;
+
+    tty.c_cflag &= ~CBAUD;
+    tty.c_cflag |= BOTHER;
+    tty.c_ispeed = baudRate;
+    tty.c_ospeed = baudRate;
+
+    return ioctl(fd, TCSETS2, &tty) == 0;
+}
+
+} // namespace Termios2
@@ -0,0 +1,16 @@
+#ifndef TERMIOS2_H
+#define TERMIOS2_H
+
+/**
+ * <asm/termbits.h>, which defines termios2, cannot be included together with <termios.h>:
+ * the termios2 calls live in their own translation unit.
+ */
+namespace Termios2
+{
+
+// Sets both input and output speed of @fd to @baudRate bit/s. Returns false on failure.
+bool setBaudRate(int fd, unsigned int baudRate);
+
+} // namespace Termios2
+
+#endif //TERMIOS2_H
@@ -0,0 +1,192 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+
+#include "MqttClient.h"
+#include "Joystick.h"
+#include "JoystickPublisher.hpp"
+#include "CommandParser.hpp"
+#include "LocalBridge.hpp"
+#include "Diagnostics.hpp"
+#include "Supervisor.hpp"
+
+#include "PolitoceanExceptions.hpp"
+#include "PolitoceanConstants.h"
+
+#include <mqttLogger.h>
+
+#include "Component.hpp"
+#include "ComponentsManager.hpp"
+
+using namespace Politocean;
+using namespace Politocean::Constants;
+
+/**************************************************************
+ * Main section
+ *
+ * PolitoceanJoystick and PolitoceanCommands in a single process:
+ * joystick updates reach the command translation through memory,
+ * and only the commands cross the broker on their way to the ROV.
+ *************************************************************/
+
+int main(int argc, const char *argv[])
+{
+    mqttLogger::setRootTag(argv[0]);
+
+    // Raw joystick topics and diagnostics go to the HMI, commands to the ROV
+    MqttClient &hmiClient = MqttClient::getInstance(Hmi::JOYSTICK_ID, Hmi::IP_ADDRESS);
+    MqttClient &rovClient = MqttClient::getInstance(Hmi::CMD_ID, Rov::IP_ADDRESS);
+
+    JoystickPublisher::Talker joystickTalker;
+    CommandParser::Listener commandListener;
+    CommandParser::Talker commandTalker;
+
+    /**
+     * --binary             : joystick updates are monitored as JoystickFrames
+     * --buttons <file>     : a different button mapping
+     * --batched            : actuator values go to the ROV in a single control frame per update
+     * --quantize <step>    : axes are reduced to levels <step> wide before looking for changes
+     * --hysteresis <value> : how far past the middle of two levels an axis must go to switch level
+     * --no-monitor         : raw joystick topics are not published at all
+     * --deadzone <value>   : axis values within ±<value> read as 0
+     * --expo <value>       : axis response from 0, linear, to 1, cubic
+     * --smoothing <value>  : low-pass weight of each new axis value, 1 is unfiltered
+     */
+    bool isMonitoring = true;
+    AxisCurve curve = LINEAR_CURVE;
+    CommandParser::Quantization quantization = CommandParser::FULL_RESOLUTION;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "--binary")
+            joystickTalker.setWireFormat(JoystickPublisher::WireFormat::BINARY);
+        else if (arg == "--batched")
+            commandTalker.setAxesFormat(CommandParser::AxesFormat::BATCHED);
+        else if (arg == "--no-monitor")
+            isMonitoring = false;
+        else if (arg == "--deadzone" && i + 1 < argc)
+            curve.deadzone = atoi(argv[++i]);
+        else if (arg == "--expo" && i + 1 < argc)
+            curve.expo = atof(argv[++i]);
+        else if (arg == "--smoothing" && i + 1 < argc)
+            curve.smoothing = atof(argv[++i]);
+        else if (arg == "--quantize" && i + 1 < argc)
+            quantization.step = atoi(argv[++i]);
+        else if (arg == "--hysteresis" && i + 1 < argc)
+            quantization.hysteresis = atoi(argv[++i]);
+        else if (arg == "--buttons" && i + 1 < argc)
+        {
+            try
+            {
+                commandTalker.loadButtonMap(argv[++i]);
+            }
+            catch (const ButtonMapException &e)
+            {
+                mqttLogger::getInstance().log(logger::ERROR, e);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    commandTalker.setQuantization(quantization);
+
+    CommandParser::LocalBridge<MqttClient> bridge(commandListener, isMonitoring ? &hmiClient : nullptr);
+
+    Joystick joystick;
+    JoystickPublisher::Listener joystickListener(joystick);
+
+    AxisConditioner conditioner;
+    conditioner.setCurve(curve);
+    joystick.setConditioner(conditioner);
+
+    ComponentsManager::Init(Hmi::COMPONENTS_ID);
+
+    // Hang ups and the broker going away wake the main thread up, which sleeps otherwise
+    Supervisor supervisor;
+    joystick.onDisconnect([&supervisor]() { supervisor.notify(Supervisor::JOYSTICK_LOST); });
+
+    /**
+     * Tries to connect the joystick until it succeeds, sleeping longer and longer between two attempts.
+     * Returns false if the broker went away in the meantime.
+     */
+    auto reconnect = [&]() {
+        Backoff backoff;
+        int nretry = 0;
+
+        while (true)
+        {
+            try
+            {
+                joystick.connect();
+                return true;
+            }
+            catch (const JoystickException &e)
+            {
+                mqttLogger::getInstance().log(logger::WARNING, "Joystick not connected.");
+                mqttLogger::getInstance().log(logger::INFO, "Reconnection attempt: " + std::to_string(nretry++));
+            }
+
+            if (supervisor.waitFor(backoff.next()) & Supervisor::BROKER_LOST)
+                return false;
+        }
+    };
+
+    ComponentsManager::SetComponentState(component_t::JOYSTICK, Component::Status::ERROR);
+
+    supervisor.watch(rovClient, Supervisor::BROKER_LOST);
+
+    if (reconnect())
+    {
+        ComponentsManager::SetComponentState(component_t::JOYSTICK, Component::Status::ENABLED);
+
+        joystick.startReading(&JoystickPublisher::Listener::listen, &joystickListener);
+
+        commandTalker.startTalking(rovClient, commandListener);
+        joystickTalker.startTalking(bridge, joystickListener);
+    }
+
+    // Latency histograms of both stages go to the pilot station every second
+    Diagnostics diagnostics;
+    diagnostics.startPublishing(hmiClient, argv[0]);
+
+    // Nothing to supervise if the broker went away before the joystick showed up
+    bool isSupervising = joystick.isConnected();
+
+    while (isSupervising)
+    {
+        unsigned int events = supervisor.wait();
+
+        if (events & Supervisor::BROKER_LOST)
+            break;
+        if (joystick.isConnected())
+            continue;
+
+        mqttLogger::getInstance().log(logger::WARNING, "Joystick disconnected! Trying to reconnect...");
+        ComponentsManager::SetComponentState(component_t::JOYSTICK, Component::Status::ERROR);
+
+        joystickTalker.stopTalking();
+        joystick.stopReading();
+
+        // Presses queued before the hang up are not replayed to the ROV
+        joystick.reset();
+
+        if (!reconnect())
+            break;
+
+        ComponentsManager::SetComponentState(component_t::JOYSTICK, Component::Status::ENABLED);
+
+        joystick.startReading(&JoystickPublisher::Listener::listen, &joystickListener);
+        joystickTalker.startTalking(bridge, joystickListener);
+    }
+
+    diagnostics.stopPublishing();
+    joystickTalker.stopTalking();
+    joystick.stopReading();
+    commandTalker.stopTalking();
+
+    return 0;
+}
@@ -1,14 +1,19 @@
-
 #include <iostream>
 #include <string>
 #include <vector>
 #include <thread>
 #include <chrono>
-#include <queue>
-#include <mutex>
+#include <memory>
+#include <cstdlib>
 
 #include "MqttClient.h"
 #include "Joystick.h"
+#include "JoystickManager.h"
+#include "JoystickRecorder.h"
+#include "JoystickPlayer.h"
+#include "JoystickPublisher.hpp"
+#include "ControllerSet.hpp"
+#include "Diagnostics.hpp"
 
 #include "PolitoceanExceptions.hpp"
 #include "PolitoceanConstants.h"
@@ -20,217 +25,165 @@
 #include "Component.hpp"
 #include "ComponentsManager.hpp"
 
-#include "Button.hpp"
-#include <Reflectables/Vector.hpp>
-
 using namespace Politocean;
 using namespace Politocean::Constants;
+using namespace Politocean::JoystickPublisher;
 
 /**************************************************************
- * Listener class for Joystick device
+ * Main section
  *************************************************************/
 
-class Listener
+int main(int argc, const char *argv[])
 {
-    std::vector<int> axes_;
-    std::queue<unsigned char> buttons_;
-    unsigned char lastButton_ = 0;
-
-public:
-    void listen(const std::vector<int> &axes, unsigned char button);
+    mqttLogger::setRootTag(argv[0]);
 
-    std::vector<int> axes();
-    unsigned char button();
-    bool isButtonUpdated();
-};
+    // Create a publisher object.
+    MqttClient &joystickPublisher = MqttClient::getInstance(Hmi::JOYSTICK_ID, Hmi::IP_ADDRESS);
+    WireFormat wireFormat = WireFormat::JSON;
 
-void Listener::listen(const std::vector<int> &axes, unsigned char button)
-{
-    axes_ = axes;
+    /**
+     * --binary             : axes and buttons are sent as compact JoystickFrames instead of JSON
+     * --record <file>      : every raw event of the pilot joystick is logged into <file>
+     * --replay <file>      : the session logged in <file> is played back instead of reading the joysticks,
+     *                        it cannot be combined with --record
+     * --fast               : the replay goes as fast as possible rather than at the original pace
+     * --deadzone <value>   : axis values within ±<value> read as 0
+     * --expo <value>       : axis response from 0, linear, to 1, cubic
+     * --smoothing <value>  : low-pass weight of each new axis value, 1 is unfiltered
+     */
+    std::string recordPath, replayPath;
+    bool isFastReplay = false;
+    AxisCurve curve = LINEAR_CURVE;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "--binary")
+            wireFormat = WireFormat::BINARY;
+        else if (arg == "--record" && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc)
+            replayPath = argv[++i];
+        else if (arg == "--fast")
+            isFastReplay = true;
+        else if (arg == "--deadzone" && i + 1 < argc)
+            curve.deadzone = atoi(argv[++i]);
+        else if (arg == "--expo" && i + 1 < argc)
+            curve.expo = atof(argv[++i]);
+        else if (arg == "--smoothing" && i + 1 < argc)
+            curve.smoothing = atof(argv[++i]);
+    }
 
-    if (buttons_.empty() && button != lastButton_ || !buttons_.empty() && button != buttons_.back())
+    // A replay reads no joystick but its own, there would be nothing to record
+    if (!recordPath.empty() && !replayPath.empty())
     {
-        buttons_.push(button);
+        mqttLogger::getInstance().log(logger::ERROR, "--record and --replay cannot be used together.");
+        return EXIT_FAILURE;
     }
-}
 
-std::vector<int> Listener::axes()
-{
-    return axes_;
-}
+    JoystickRecorder recorder;
+    std::unique_ptr<JoystickPlayer> player;
 
-unsigned char Listener::button()
-{
-    if (buttons_.empty())
-        return lastButton_;
+    try
+    {
+        if (!recordPath.empty())
+            recorder.start(recordPath);
+        if (!replayPath.empty())
+            player.reset(new JoystickPlayer(replayPath));
+    }
+    catch (const JoystickException &e)
+    {
+        mqttLogger::getInstance().log(logger::ERROR, e);
+        return EXIT_FAILURE;
+    }
 
-    unsigned char button = buttons_.front();
-    buttons_.pop();
-    if (buttons_.empty())
-        lastButton_ = button;
+    AxisConditioner conditioner;
+    conditioner.setCurve(curve);
 
-    return button;
-}
+    ComponentsManager::Init(Hmi::COMPONENTS_ID);
 
-bool Listener::isButtonUpdated()
-{
-    return !buttons_.empty();
-}
+    // Latency histograms go to the pilot station every second
+    Diagnostics diagnostics;
+    diagnostics.startPublishing(joystickPublisher, argv[0]);
 
-/**************************************************************
- * Talker class for Joystick publisher
- *************************************************************/
+    // A replay plays the log on a device of its own, and ends with it once the talkers had the time to send its last events
+    if (player)
+    {
+        Joystick joystick(player->getDevice());
+        Listener listener(joystick);
+        Talker talker;
 
-class Talker
-{
-    /**
-	 * @axesTalker		: talker thread for axes values
-	 * @buttonTalker	: talker thread for button value
-	 */
-    std::thread *axesTalker_, *buttonTalker_;
+        joystick.setConditioner(conditioner);
+        joystick.connect();
+        ComponentsManager::SetComponentState(component_t::JOYSTICK, Component::Status::ENABLED);
 
-    /**
-	 * @isTalking_ : it is true if the talker is talking
-	 */
-    bool isTalking_ = false;
+        talker.setWireFormat(wireFormat);
+        joystick.startReading(&Listener::listen, &listener);
+        talker.startTalking(joystickPublisher, listener);
 
-public:
-    void startTalking(MqttClient &publisher, Listener &listener);
-    void stopTalking();
+        player->play(isFastReplay ? 0 : 1);
+        player->wait();
 
-    bool isTalking();
-};
+        std::this_thread::sleep_for(std::chrono::seconds(1));
 
-void Talker::startTalking(MqttClient &publisher, Listener &listener)
-{
-    if (isTalking_)
-        return;
+        talker.stopTalking();
+        joystick.stopReading();
 
-    isTalking_ = true;
+        return 0;
+    }
 
-    axesTalker_ = new std::thread([&]() {
-        while (isTalking_)
+    /**
+     * Controllers come and go with their device nodes: talkers are started as soon as a joystick
+     * is attached and stopped as soon as it is unplugged. The pilot is the first one attached,
+     * then whichever is still plugged in when it goes away.
+     */
+    ControllerSet<MqttClient> controllers(joystickPublisher);
+
+    controllers.setWireFormat(wireFormat);
+    if (recorder.isRecording())
+        controllers.setRecorder(&recorder);
+
+    controllers.onPilot([](const std::string &device) {
+        if (device.empty())
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(Timing::Milliseconds::COMMANDS));
-
-            Types::Vector<int> axes = listener.axes();
-
-            publisher.publish(Topics::JOYSTICK_AXES, axes);
+            mqttLogger::getInstance().log(logger::WARNING, "Pilot joystick disconnected! Waiting for a joystick...");
+            ComponentsManager::SetComponentState(component_t::JOYSTICK, Component::Status::ERROR);
+            return;
         }
 
-        isTalking_ = false;
+        mqttLogger::getInstance().log(logger::INFO, "Pilot joystick: " + device);
+        ComponentsManager::SetComponentState(component_t::JOYSTICK, Component::Status::ENABLED);
     });
 
-    buttonTalker_ = new std::thread([&]() {
-        unsigned char btn;
-
-        while (isTalking_)
-        {
-            if (!listener.isButtonUpdated())
-            {
-                continue;
-            }
-            btn = listener.button();
-
-            Button button(btn & 0x7F, (btn >> 7) & 0x01);
-            publisher.publish(Topics::JOYSTICK_BUTTONS, button);
-        }
+    JoystickManager manager;
 
-        isTalking_ = false;
+    manager.onAttach([&](Joystick &joystick) {
+        joystick.setConditioner(conditioner);
+        controllers.attach(joystick);
     });
-}
 
-void Talker::stopTalking()
-{
-    if (!isTalking_)
-        return;
-
-    isTalking_ = false;
-    axesTalker_->join();
-    buttonTalker_->join();
-}
-
-bool Talker::isTalking()
-{
-    return isTalking_;
-}
-
-/**************************************************************
- * Main section
- *************************************************************/
-
-int main(int argc, const char *argv[])
-{
-    mqttLogger::setRootTag(argv[0]);
-
-    // Create a publisher object and a talker.
-    MqttClient &joystickPublisher = MqttClient::getInstance(Hmi::JOYSTICK_ID, Hmi::IP_ADDRESS);
-    Talker talker;
+    manager.onDetach([&](Joystick &joystick) {
+        controllers.detach(joystick);
+    });
 
-    // Create a joystick object and a listener.
-    Joystick joystick;
-    Listener listener;
+    // Nothing is attached yet: the manager enables the component with the first joystick
+    ComponentsManager::SetComponentState(component_t::JOYSTICK, Component::Status::ERROR);
 
-    ComponentsManager::Init(Hmi::COMPONENTS_ID);
-
-    // Try to connect to the joystick device.
-    // If error has caught, terminate with EXIT_FAILURE
-    while (!joystick.isConnected())
+    try
     {
-        try
-        {
-            joystick.connect();
-        }
-        catch (const JoystickException &e)
-        {
-            mqttLogger::getInstance().log(logger::WARNING, "Joystick not connected.");
-            ComponentsManager::SetComponentState(component_t::JOYSTICK, Component::Status::ERROR);
-        }
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        manager.start();
     }
-
-    ComponentsManager::SetComponentState(component_t::JOYSTICK, Component::Status::ENABLED);
-
-    // Start reading data from the joystick device.
-    joystick.startReading(&Listener::listen, &listener);
-    // Start talker talking
-    talker.startTalking(joystickPublisher, listener);
-
-    while (joystickPublisher.is_connected())
+    catch (const JoystickException &e)
     {
-        if (joystick.isConnected())
-            continue;
-
-        ComponentsManager::SetComponentState(component_t::JOYSTICK, Component::Status::ERROR);
-
-        talker.stopTalking();
-
-        int nretry = 0;
-        while (!joystick.isConnected())
-        {
-            mqttLogger::getInstance().log(logger::WARNING, "Joystick disconnected! Trying to reconnect...");
-            mqttLogger::getInstance().log(logger::INFO, "Reconnection attempt: " + to_string(nretry++));
-
-            try
-            {
-                joystick.connect();
-            }
-            catch (const std::exception &e)
-            {
-                mqttLogger::getInstance().log(logger::WARNING, e);
-            }
-            catch (...)
-            {
-                mqttLogger::getInstance().log(logger::WARNING, "Can't connect to joystick.");
-            }
-
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-        }
+        mqttLogger::getInstance().log(logger::ERROR, e);
+        return EXIT_FAILURE;
+    }
 
-        ComponentsManager::SetComponentState(component_t::JOYSTICK, Component::Status::ENABLED);
+    // Joysticks are looked after by the manager thread: this one sleeps until the broker goes away
+    joystickPublisher.wait();
 
-        talker.startTalking(joystickPublisher, listener);
-    }
+    manager.stop();
 
     return 0;
 }
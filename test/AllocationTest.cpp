@@ -0,0 +1,134 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "Joystick.h"
+#include "JoystickPublisher.hpp"
+#include "CommandParser.hpp"
+#include "LocalBridge.hpp"
+#include "JsonPayload.hpp"
+
+#include "SyntheticJoystick.hpp"
+
+using namespace Politocean;
+
+/**
+ * Every heap allocation of the process goes through these, and is counted while @isCounting is set,
+ * whichever thread makes it. The array forms default to these two.
+ * They are kept out of line: inlined, the compiler would see the memory of a new expression go to free().
+ */
+static std::atomic<bool> isCounting{false};
+static std::atomic<unsigned long> allocations{0};
+
+__attribute__((noinline)) void *operator new(std::size_t size)
+{
+    if (isCounting)
+        allocations++;
+
+    void *p = malloc(size ? size : 1);
+    if (p == nullptr)
+        throw std::bad_alloc();
+
+    return p;
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+static const std::string DEVICE_PATH = "/tmp/politocean_allocation_test_js0";
+
+static const int NUM_AXES = 7, NUM_BUTTONS = 8;
+static const std::vector<int> MASH_BUTTONS = {0, 3, 5};
+
+// The ROV side: it only counts what reaches it
+struct CountingClient
+{
+    std::atomic<unsigned long> messages{0};
+
+    void publish(const std::string &, const std::string &)
+    {
+        messages++;
+    }
+
+    bool is_connected()
+    {
+        return true;
+    }
+};
+
+TEST_CASE("The steady-state control loop does not allocate", "[allocation]")
+{
+    JoystickPublisher::WireFormat wireFormat = GENERATE(JoystickPublisher::WireFormat::JSON, JoystickPublisher::WireFormat::BINARY);
+
+    SyntheticJoystick device(DEVICE_PATH, NUM_AXES, NUM_BUTTONS);
+    CountingClient rov;
+
+    Joystick joystick(device.path());
+    JoystickPublisher::Listener joystickListener(joystick);
+    JoystickPublisher::Talker joystickTalker;
+
+    CommandParser::Listener commandListener;
+    CommandParser::Talker commandTalker;
+    CommandParser::LocalBridge<CountingClient> bridge(commandListener);
+
+    joystickTalker.setWireFormat(wireFormat);
+
+    joystick.connect();
+    joystick.startReading(&JoystickPublisher::Listener::listen, &joystickListener);
+    joystickTalker.startTalking(bridge, joystickListener);
+    commandTalker.startTalking(rov, commandListener);
+
+    // Warm up: every buffer reaches its working size and every lazy static is built
+    device.play(SyntheticJoystick::Pattern::SWEEP, 100, 1000);
+    device.play(SyntheticJoystick::Pattern::BUTTON_MASH, 10, 100, MASH_BUTTONS);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // The steps are built before counting starts, the synthetic joystick itself is not under test
+    std::vector<SyntheticJoystick::Step> steps;
+    for (int i = 0; i < 200; i++)
+    {
+        steps.push_back(device.step(SyntheticJoystick::Pattern::SWEEP, i, MASH_BUTTONS));
+        if (i % 10 == 0)
+            steps.push_back(device.step(SyntheticJoystick::Pattern::BUTTON_MASH, i / 10, MASH_BUTTONS));
+    }
+
+    unsigned long messages = rov.messages;
+
+    isCounting = true;
+
+    for (const SyntheticJoystick::Step &step : steps)
+    {
+        device.write(step);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    isCounting = false;
+
+    joystickTalker.stopTalking();
+    joystick.stopReading();
+    commandTalker.stopTalking();
+
+    REQUIRE(rov.messages > messages);
+    REQUIRE(allocations == 0);
+}
+
+TEST_CASE("Control payloads are written as the reflectables stringify them", "[allocation]")
+{
+    std::string payload;
+
+    toJson(payload, std::vector<int>{-32767, 0, 12}.data(), 3);
+    REQUIRE(payload == Types::Vector<int>(std::vector<int>{-32767, 0, 12}).stringify());
+
+    buttonToJson(payload, 4, 1);
+    REQUIRE(payload == Button(4, 1).stringify());
+}
@@ -0,0 +1,167 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+
+#include "Joystick.h"
+#include "AxisConditioner.h"
+
+#include "SyntheticJoystick.hpp"
+
+using namespace Politocean;
+
+TEST_CASE("A linear curve leaves axes untouched", "[conditioning]")
+{
+    AxisConditioner conditioner;
+
+    REQUIRE_FALSE(conditioner.isEnabled());
+
+    for (int value : {-32767, -1, 0, 1, 12345, 32767})
+        REQUIRE(conditioner.apply(0, value) == value);
+
+    // Out of the joydev range values are clamped, unknown axes passed through
+    REQUIRE(conditioner.apply(0, -32768) == -32767);
+    REQUIRE(conditioner.apply(AxisConditioner::MAX_AXES, -32768) == -32768);
+}
+
+TEST_CASE("Deadzone and expo shape the response symmetrically", "[conditioning]")
+{
+    AxisConditioner conditioner;
+    conditioner.setCurve(AxisCurve{1000, 0.5, 1});
+
+    REQUIRE(conditioner.isEnabled());
+
+    SECTION("Noise around the center reads as 0")
+    {
+        for (int value = -1000; value <= 1000; value += 50)
+            REQUIRE(conditioner.apply(1, value) == 0);
+    }
+
+    SECTION("Full deflection stays full")
+    {
+        REQUIRE(conditioner.apply(1, 32767) == 32767);
+        REQUIRE(conditioner.apply(1, -32767) == -32767);
+    }
+
+    SECTION("The response is monotonic and odd")
+    {
+        int previous = 0;
+        for (int value = 0; value <= 32767; value++)
+        {
+            int shaped = conditioner.apply(1, value);
+
+            REQUIRE(shaped >= previous);
+            REQUIRE(conditioner.apply(1, -value) == -shaped);
+            previous = shaped;
+        }
+    }
+
+    SECTION("Expo makes half deflection finer than linear")
+    {
+        AxisConditioner linear;
+        linear.setCurve(AxisCurve{1000, 0, 1});
+
+        REQUIRE(conditioner.apply(1, 16384) < linear.apply(1, 16384));
+    }
+}
+
+TEST_CASE("Smoothing filters steps and settles on them", "[conditioning]")
+{
+    AxisConditioner conditioner;
+    conditioner.setCurve(2, AxisCurve{0, 0, 0.25});
+
+    // Only axis 2 is filtered
+    REQUIRE(conditioner.apply(0, 20000) == 20000);
+    REQUIRE(conditioner.reset(2, -5000) == -5000);
+
+    int first = conditioner.apply(2, 20000);
+    REQUIRE(first == 1250);
+
+    int value = first;
+    for (int i = 0; i < 100; i++)
+    {
+        int next = conditioner.apply(2, 20000);
+        REQUIRE(next >= value);
+        value = next;
+    }
+
+    REQUIRE(value == 20000);
+}
+
+TEST_CASE("A filtered axis reaches the stick without further events and stops when centered", "[conditioning]")
+{
+    AxisConditioner conditioner;
+    conditioner.setCurve(AxisCurve{2000, 0, 0.3});
+
+    for (int value : {8000, 20000, 32767, 15000})
+        conditioner.apply(0, value);
+
+    // Devices are silent while the stick is held: settling alone gets there
+    AxisConditioner unfiltered;
+    unfiltered.setCurve(AxisCurve{2000, 0, 1});
+    int held = unfiltered.apply(0, 15000);
+
+    int value = 0;
+    for (int i = 0; i < 100 && !conditioner.isSettled(); i++)
+        value = conditioner.settle(0);
+
+    REQUIRE(conditioner.isSettled());
+    REQUIRE(value == held);
+
+    // Releasing the stick is a single event into the deadzone
+    REQUIRE(conditioner.apply(0, 0) == 0);
+    REQUIRE(conditioner.isSettled());
+}
+
+TEST_CASE("A joystick conditions its axes but not the initial state filter", "[conditioning]")
+{
+    const std::string DEVICE_PATH = "/tmp/politocean_conditioner_test_js0";
+
+    SyntheticJoystick device(DEVICE_PATH, 2, 2);
+    Joystick joystick(device.path());
+
+    AxisConditioner conditioner;
+    conditioner.setCurve(AxisCurve{2000, 0, 0.5});
+    joystick.setConditioner(conditioner);
+
+    joystick.connect();
+
+    struct Reader
+    {
+        std::vector<int> axes;
+        void listen(const std::vector<int> &values, unsigned char) { axes = values; }
+    } reader;
+
+    joystick.startReading(&Reader::listen, &reader);
+
+    // Jitter within the deadzone never moves the axes
+    for (int i = 0; i < 20; i++)
+    {
+        device.write({SyntheticJoystick::event(JS_EVENT_AXIS, 0, i % 2 ? 1500 : -1500)});
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    REQUIRE(joystick.getAxis(0) == 0);
+
+    // A single event: the axis gets to full deflection on its own
+    device.write({SyntheticJoystick::event(JS_EVENT_AXIS, 1, 32767)});
+
+    for (int i = 0; i < 100 && joystick.getAxis(1) != 32767; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    REQUIRE(joystick.getAxis(1) == 32767);
+
+    // Released, it is centered at once
+    device.write({SyntheticJoystick::event(JS_EVENT_AXIS, 1, 0)});
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    REQUIRE(joystick.getAxis(1) == 0);
+
+    joystick.stopReading();
+
+    REQUIRE(reader.axes[1] == 0);
+}
@@ -0,0 +1,141 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include <json.hpp>
+
+#include "PolitoceanConstants.h"
+
+#include "CommandParser.hpp"
+#include "Diagnostics.hpp"
+
+using namespace Politocean;
+using namespace Politocean::Constants::Commands;
+using namespace Politocean::CommandParser;
+
+// Counts the updates of @samples, fed to axis 0, which change it after quantization
+static int countChanges(AxisQuantizer &quantizer, const std::vector<int> &samples)
+{
+    AxesState state;
+    int changes = 0;
+
+    for (int sample : samples)
+    {
+        std::fill(state.values, state.values + AxesState::MAX_AXES, 0);
+        state.values[0] = sample;
+
+        quantizer.apply(state.values);
+        if (state.update())
+            changes++;
+    }
+
+    return changes;
+}
+
+TEST_CASE("Quantization cuts sensor noise by an order of magnitude", "[quantization]")
+{
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> noise(-200, 200);
+
+    // Steady flight: the stick held at a cruise position, with sensor noise on top
+    std::vector<int> samples;
+    for (int i = 0; i < 1000; i++)
+        samples.push_back(12000 + noise(random));
+
+    AxisQuantizer full;
+    AxisQuantizer coarse;
+    coarse.set(Quantization{512, 256});
+
+    int rawChanges = countChanges(full, samples);
+    int quantizedChanges = countChanges(coarse, samples);
+
+    REQUIRE(rawChanges > 900);
+    REQUIRE(quantizedChanges * 10 < rawChanges);
+}
+
+TEST_CASE("Hysteresis keeps an axis on a level boundary from flickering", "[quantization]")
+{
+    // Around 256, half way between levels 0 and 1 of a 512 step
+    std::vector<int> samples;
+    for (int i = 0; i < 100; i++)
+        samples.push_back(i % 2 ? 300 : 210);
+
+    AxisQuantizer withoutHysteresis;
+    withoutHysteresis.set(Quantization{512, 0});
+
+    AxisQuantizer withHysteresis;
+    withHysteresis.set(Quantization{512, 64});
+
+    REQUIRE(countChanges(withoutHysteresis, samples) > 50);
+    REQUIRE(countChanges(withHysteresis, samples) == 0);
+}
+
+TEST_CASE("Quantized axes keep their full range", "[quantization]")
+{
+    AxisQuantizer quantizer;
+    quantizer.set(Quantization{4096, 256});
+    quantizer.set(1, FULL_RESOLUTION);
+
+    int values[AxesState::MAX_AXES] = {32767, 12345, -32767, 1000};
+    quantizer.apply(values);
+
+    REQUIRE(values[0] == 32767);
+    REQUIRE(values[1] == 12345);
+    REQUIRE(values[2] == -32767);
+    REQUIRE(values[3] == 0);
+}
+
+// The ROV side: it only counts what reaches it
+struct CountingClient
+{
+    std::atomic<unsigned long> messages{0};
+
+    void publish(const std::string &, const std::string &)
+    {
+        messages++;
+    }
+
+    bool is_connected()
+    {
+        return true;
+    }
+};
+
+TEST_CASE("The axes talker counts the publishes quantization suppressed", "[quantization]")
+{
+    Listener listener;
+    Talker talker;
+    CountingClient rov;
+
+    talker.setQuantization(Quantization{512, 256});
+    talker.startTalking(rov, listener);
+
+    Diagnostics::report("AxisQuantizerTest", 1000);
+
+    std::vector<int> axes(Axes::PITCH + 1, 0);
+    for (int i = 0; i < 20; i++)
+    {
+        // X and the shoulder jitter around a held position
+        axes[Axes::X] = 8000 + (i % 2 ? 100 : -100);
+        axes[Axes::SHOULDER] = -4000 + (i % 3) * 50;
+
+        listener.setAxes(axes.data(), axes.size());
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    talker.stopTalking();
+
+    // Only the first update goes through, as one AXES and one SHOULDER_VELOCITY message
+    REQUIRE(rov.messages == 2);
+    REQUIRE(talker.getSuppressed() >= 30);
+
+    auto j_report = nlohmann::json::parse(Diagnostics::report("AxisQuantizerTest", 1000));
+    REQUIRE(j_report["counters"]["commands.suppressed"] == talker.getSuppressed());
+}
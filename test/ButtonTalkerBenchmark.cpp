@@ -0,0 +1,129 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "JoystickPublisher.hpp"
+
+using namespace Politocean;
+using namespace Politocean::Constants;
+using namespace Politocean::JoystickPublisher;
+
+/*
+ * CPU usage regression benchmark for the joystick talkers.
+ * The joystick is mocked by a FIFO fed with js_events, the MQTT client by a counter.
+ */
+
+static const std::string FIFO_PATH = "/tmp/politocean_joystick_benchmark";
+
+class MockPublisher
+{
+public:
+    std::atomic<int> buttons{0};
+    std::atomic<int> axes{0};
+
+    void publish(const std::string &topic, const std::string &payload)
+    {
+        if (topic == Topics::JOYSTICK_BUTTONS)
+        {
+            buttons++;
+            return;
+        }
+        if (topic == Topics::JOYSTICK_AXES)
+        {
+            axes++;
+            return;
+        }
+
+        JoystickFrame frame;
+        if (JoystickFrame::decode(payload.data(), payload.size(), frame) && frame.buttons != lastButtons)
+            buttons++;
+        else
+            axes++;
+        lastButtons = frame.buttons;
+    }
+
+private:
+    uint64_t lastButtons = 0;
+};
+
+static double processCpuSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+TEST_CASE("Joystick talkers do not burn CPU while idle", "[benchmark]")
+{
+    unlink(FIFO_PATH.c_str());
+    REQUIRE(mkfifo(FIFO_PATH.c_str(), 0600) == 0);
+
+    // Opened read-write first, so that the joystick open does not block on the FIFO
+    int device = open(FIFO_PATH.c_str(), O_RDWR);
+    REQUIRE(device != -1);
+
+    Joystick joystick(FIFO_PATH);
+    joystick.connect();
+
+    Listener listener(joystick);
+    Talker talker;
+    MockPublisher publisher;
+
+    joystick.startReading(&Listener::listen, &listener);
+    talker.startTalking(publisher, listener);
+
+    const double IDLE_SECONDS = 2.0;
+
+    double cpuStart = processCpuSeconds();
+    std::this_thread::sleep_for(std::chrono::duration<double>(IDLE_SECONDS));
+    double idleUsage = (processCpuSeconds() - cpuStart) / IDLE_SECONDS;
+
+    std::cout << "Idle CPU usage: " << idleUsage * 100 << "% of a core" << std::endl;
+
+    // Press latency: time from the device write to the publish
+    const int PRESSES = 200;
+    std::vector<double> latencies;
+
+    for (int i = 0; i < PRESSES; i++)
+    {
+        struct js_event js = {};
+        js.type = JS_EVENT_BUTTON;
+        js.number = i % 20;
+        js.value = i % 2;
+
+        int published = publisher.buttons;
+        auto start = std::chrono::steady_clock::now();
+
+        REQUIRE(write(device, &js, sizeof(js)) == sizeof(js));
+        while (publisher.buttons == published)
+            ;
+
+        latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << "Press to publish latency: p50 " << latencies[PRESSES / 2] << " us, p99 "
+              << latencies[PRESSES * 99 / 100] << " us" << std::endl;
+
+    talker.stopTalking();
+    joystick.stopReading();
+
+    close(device);
+    unlink(FIFO_PATH.c_str());
+
+    REQUIRE(publisher.buttons == PRESSES);
+    // The button talker used to spin a whole core
+    REQUIRE(idleUsage < 0.05);
+}
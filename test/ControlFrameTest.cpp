@@ -0,0 +1,155 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <utility>
+#include <algorithm>
+#include <condition_variable>
+
+#include "PolitoceanConstants.h"
+
+#include "ControlFrame.hpp"
+#include "CommandParser.hpp"
+
+using namespace Politocean;
+using namespace Politocean::Constants;
+using namespace Politocean::Constants::Commands;
+
+TEST_CASE("ControlFrame survives a round trip with only the changed fields", "[frame]")
+{
+    ControlFrame frame;
+    frame.sequence = 4000000000U;
+    frame.fields = ControlFrame::AXES | ControlFrame::WRIST;
+    frame.axes[0] = -32767;
+    frame.axes[3] = 32767;
+    frame.wrist = -12;
+    frame.hand = 99;
+
+    std::string payload;
+    frame.toJson(payload);
+    REQUIRE(payload == "{\"seq\":4000000000,\"axes\":[-32767,0,0,32767],\"wrist\":-12}");
+
+    ControlFrame decoded;
+    REQUIRE(ControlFrame::parse(payload, decoded));
+
+    REQUIRE(decoded.sequence == 4000000000U);
+    REQUIRE(decoded.fields == frame.fields);
+    REQUIRE(decoded.axes[0] == -32767);
+    REQUIRE(decoded.axes[3] == 32767);
+    REQUIRE(decoded.wrist == -12);
+    REQUIRE_FALSE(decoded.has(ControlFrame::HAND));
+
+    REQUIRE_FALSE(ControlFrame::parse("[1, 2, 3, 4]", decoded));
+    REQUIRE_FALSE(ControlFrame::parse("{\"seq\":1,\"axes\":[1,2]}", decoded));
+}
+
+// The ROV side: it keeps every message it gets
+struct RecordingClient
+{
+    std::mutex mutex;
+    std::condition_variable received;
+    std::vector<std::pair<std::string, std::string>> messages;
+
+    void publish(const std::string &topic, const std::string &payload)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        messages.push_back(std::make_pair(topic, payload));
+        received.notify_all();
+    }
+
+    bool is_connected()
+    {
+        return true;
+    }
+
+    std::vector<std::pair<std::string, std::string>> take()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return std::move(messages);
+    }
+};
+
+static std::vector<std::pair<std::string, std::string>> update(CommandParser::Listener &listener, RecordingClient &rov, const std::vector<int> &axes)
+{
+    listener.setAxes(axes.data(), axes.size());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    return rov.take();
+}
+
+TEST_CASE("A batched axes talker sends one control frame per update", "[frame]")
+{
+    CommandParser::Listener listener;
+    CommandParser::Talker talker;
+    RecordingClient rov;
+    ControlFrame frame;
+
+    talker.setAxesFormat(CommandParser::AxesFormat::BATCHED);
+    talker.startTalking(rov, listener);
+
+    std::vector<int> axes(Axes::PITCH + 1, 0);
+
+    // X and the shoulder at once: both in a single frame
+    axes[Axes::X] = 1000;
+    axes[Axes::SHOULDER] = -500;
+    auto messages = update(listener, rov, axes);
+
+    REQUIRE(messages.size() == 1);
+    REQUIRE(messages[0].first == CONTROL_FRAME_TOPIC);
+    REQUIRE(ControlFrame::parse(messages[0].second, frame));
+    REQUIRE(frame.sequence == 1);
+    REQUIRE(frame.fields == (ControlFrame::AXES | ControlFrame::SHOULDER));
+    REQUIRE(frame.axes[0] == 1000);
+    REQUIRE(frame.shoulder == -500);
+
+    // Nothing changed: nothing sent
+    REQUIRE(update(listener, rov, axes).empty());
+
+    axes[Axes::HAND] = 7;
+    messages = update(listener, rov, axes);
+
+    REQUIRE(messages.size() == 1);
+    REQUIRE(ControlFrame::parse(messages[0].second, frame));
+    REQUIRE(frame.sequence == 2);
+    REQUIRE(frame.fields == ControlFrame::HAND);
+    REQUIRE(frame.hand == 7);
+
+    talker.stopTalking();
+}
+
+TEST_CASE("An axes update is sent as soon as it comes, not on the next poll", "[frame]")
+{
+    CommandParser::Listener listener;
+    CommandParser::Talker talker;
+    RecordingClient rov;
+
+    talker.startTalking(rov, listener);
+
+    std::vector<int> axes(Axes::PITCH + 1, 0);
+    std::vector<std::chrono::steady_clock::duration> delays;
+
+    for (int i = 1; i <= 21; i++)
+    {
+        // A random phase against any polling period
+        std::this_thread::sleep_for(std::chrono::microseconds(1000 + 337 * i));
+
+        axes[Axes::X] = i * 100;
+        auto start = std::chrono::steady_clock::now();
+        listener.setAxes(axes.data(), axes.size());
+
+        std::unique_lock<std::mutex> lock(rov.mutex);
+        REQUIRE(rov.received.wait_for(lock, std::chrono::seconds(1), [&rov]() { return !rov.messages.empty(); }));
+        delays.push_back(std::chrono::steady_clock::now() - start);
+        rov.messages.clear();
+    }
+
+    talker.stopTalking();
+
+    // A talker polling every Timing::Milliseconds::JOYSTICK would take half of it on average
+    std::nth_element(delays.begin(), delays.begin() + delays.size() / 2, delays.end());
+    REQUIRE(delays[delays.size() / 2] < std::chrono::milliseconds(1));
+}
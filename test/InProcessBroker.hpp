@@ -0,0 +1,161 @@
+#ifndef IN_PROCESS_BROKER_H
+#define IN_PROCESS_BROKER_H
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+
+#include "Reflectable.hpp"
+
+/**
+ * In-process stand-in for MqttClient, with the same publish and subscribeTo calls.
+ * Messages are delivered in publish order from a single delivery thread, as a network
+ * client runs its callbacks, so publishers never run subscribers on their own thread.
+ * Every message carries its publish time, which observers get along with it.
+ */
+class InProcessBroker
+{
+public:
+    typedef std::chrono::steady_clock::time_point time_point_t;
+
+    struct Message
+    {
+        std::string topic, payload;
+        time_point_t published;
+    };
+
+    typedef std::function<void(const std::string &payload)> callback_t;
+    typedef std::function<void(const Message &message)> observer_t;
+
+private:
+    std::multimap<std::string, callback_t> subscribers_;
+    std::vector<observer_t> observers_;
+
+    // Messages not delivered yet, guarded by @mutex_
+    std::deque<Message> queue_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    std::atomic<bool> isConnected_;
+    std::thread deliveryThread_;
+
+    static const std::string &parse(const std::string &payload, const std::string *)
+    {
+        return payload;
+    }
+
+    template <class T>
+    static T parse(const std::string &payload, const T *)
+    {
+        return T::parse(payload);
+    }
+
+    void deliver()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        while (isConnected_ || !queue_.empty())
+        {
+            cv_.wait(lock, [&]() { return !isConnected_ || !queue_.empty(); });
+            if (queue_.empty())
+                continue;
+
+            Message message = std::move(queue_.front());
+            queue_.pop_front();
+
+            lock.unlock();
+
+            for (const observer_t &observer : observers_)
+                observer(message);
+
+            auto range = subscribers_.equal_range(message.topic);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                try
+                {
+                    it->second(message.payload);
+                }
+                catch (const Reflectable::ReflectableParsingException &)
+                {
+                    // A malformed payload is dropped, as the real client does
+                }
+            }
+
+            lock.lock();
+        }
+    }
+
+public:
+    InProcessBroker() : isConnected_(true), deliveryThread_(&InProcessBroker::deliver, this) {}
+
+    ~InProcessBroker()
+    {
+        disconnect();
+    }
+
+    // Subscriptions and observers must be set up before the first publish
+    void subscribeTo(const std::string &topic, callback_t callback)
+    {
+        subscribers_.insert(std::make_pair(topic, callback));
+    }
+
+    // As MqttClient::subscribeTo: the payload is parsed into the argument type of @fp
+    template <class M, class T, class P>
+    void subscribeTo(const std::string &topic, void (T::*fp)(P), M *obj)
+    {
+        typedef typename std::decay<P>::type payload_t;
+
+        subscribeTo(topic, [fp, obj](const std::string &payload) {
+            (obj->*fp)(parse(payload, (const payload_t *)nullptr));
+        });
+    }
+
+    void observe(observer_t observer)
+    {
+        observers_.push_back(observer);
+    }
+
+    void publish(const std::string &topic, const std::string &payload)
+    {
+        Message message = {topic, payload, std::chrono::steady_clock::now()};
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::move(message));
+        }
+        cv_.notify_one();
+    }
+
+    void publish(const std::string &topic, Reflectable::IReflectable &payload)
+    {
+        publish(topic, payload.stringify());
+    }
+
+    bool is_connected()
+    {
+        return isConnected_;
+    }
+
+    // Delivers what is still queued, then stops
+    void disconnect()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            isConnected_ = false;
+        }
+        cv_.notify_one();
+
+        if (deliveryThread_.joinable())
+            deliveryThread_.join();
+    }
+};
+
+#endif //IN_PROCESS_BROKER_H
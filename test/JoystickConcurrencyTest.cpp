@@ -0,0 +1,94 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <thread>
+#include <vector>
+#include <atomic>
+
+#include "RingBuffer.h"
+#include "TripleBuffer.h"
+
+using namespace Politocean;
+
+/*
+ * Stress tests for the structures shared by the joystick thread and the talkers.
+ * Configure with -DENABLE_TSAN=ON to build them with -fsanitize=thread: any race is then reported by ThreadSanitizer.
+ */
+
+static const int ITERATIONS = 200000;
+static const int NUM_AXES = 8;
+
+TEST_CASE("TripleBuffer never hands out a torn snapshot", "[concurrency]")
+{
+    TripleBuffer<std::vector<int>> axes(std::vector<int>(NUM_AXES, 0));
+
+    std::thread writer([&]() {
+        std::vector<int> values(NUM_AXES);
+        for (int i = 1; i <= ITERATIONS; i++)
+        {
+            for (int &value : values)
+                value = i;
+            axes.write(values);
+        }
+    });
+
+    int last = 0;
+    bool torn = false, backwards = false;
+    while (last < ITERATIONS)
+    {
+        const std::vector<int> &snapshot = axes.read();
+
+        for (int value : snapshot)
+            torn |= value != snapshot[0];
+        backwards |= snapshot[0] < last;
+
+        last = snapshot[0];
+    }
+
+    writer.join();
+
+    REQUIRE_FALSE(torn);
+    REQUIRE_FALSE(backwards);
+}
+
+TEST_CASE("RingBuffer delivers every element in order", "[concurrency]")
+{
+    RingBuffer<int, 256> queue;
+
+    std::thread producer([&]() {
+        for (int i = 0; i < ITERATIONS; i++)
+            while (!queue.push(i))
+                std::this_thread::yield();
+    });
+
+    int expected = 0;
+    bool ordered = true;
+    while (expected < ITERATIONS)
+    {
+        int value;
+        if (!queue.pop(value))
+            continue;
+
+        ordered &= value == expected;
+        expected++;
+    }
+
+    producer.join();
+
+    REQUIRE(ordered);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("RingBuffer refuses to overwrite when full", "[concurrency]")
+{
+    RingBuffer<int, 4> queue;
+
+    for (int i = 0; i < 4; i++)
+        REQUIRE(queue.push(i));
+    REQUIRE_FALSE(queue.push(4));
+
+    int value;
+    REQUIRE(queue.pop(value));
+    REQUIRE(value == 0);
+    REQUIRE(queue.size() == 3);
+}
@@ -0,0 +1,172 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdarg>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/input.h>
+
+#include "Joystick.h"
+
+using namespace Politocean;
+
+/*
+ * A FIFO stands in for /dev/input/eventN. The evdev ioctls a Joystick makes on it are answered here,
+ * from @keyState and @absValue, as the kernel would answer them for a stick with two axes and two buttons.
+ * Every other ioctl goes to the kernel.
+ */
+
+static const std::string DEVICE_PATH = "/tmp/politocean_evdev_test_event0";
+
+static unsigned long keyState[KEY_CNT / (sizeof(unsigned long) * 8) + 1];
+static int absValue[ABS_CNT];
+
+static void setBit(unsigned long *bits, int bit, bool value)
+{
+    const int longBits = sizeof(unsigned long) * 8;
+
+    if (value)
+        bits[bit / longBits] |= 1UL << (bit % longBits);
+    else
+        bits[bit / longBits] &= ~(1UL << (bit % longBits));
+}
+
+extern "C" int ioctl(int fd, unsigned long request, ...) noexcept
+{
+    va_list args;
+    va_start(args, request);
+    void *arg = va_arg(args, void *);
+    va_end(args);
+
+    struct stat info;
+    if (fstat(fd, &info) < 0 || !S_ISFIFO(info.st_mode) || _IOC_TYPE(request) != 'E' || _IOC_DIR(request) != _IOC_READ)
+        return syscall(SYS_ioctl, fd, request, arg);
+
+    unsigned int nr = _IOC_NR(request), size = _IOC_SIZE(request);
+
+    if (nr == _IOC_NR(EVIOCGNAME(0)))
+    {
+        strncpy(static_cast<char *>(arg), "Synthetic evdev stick", size);
+        return 0;
+    }
+    if (nr == _IOC_NR(EVIOCGKEY(0)))
+    {
+        memcpy(arg, keyState, std::min<std::size_t>(size, sizeof(keyState)));
+        return 0;
+    }
+    if (nr == _IOC_NR(EVIOCGBIT(EV_ABS, 0)) || nr == _IOC_NR(EVIOCGBIT(EV_KEY, 0)))
+    {
+        unsigned long *bits = static_cast<unsigned long *>(arg);
+        memset(bits, 0, size);
+
+        if (nr == _IOC_NR(EVIOCGBIT(EV_ABS, 0)))
+        {
+            setBit(bits, ABS_X, true);
+            setBit(bits, ABS_Y, true);
+        }
+        else
+        {
+            setBit(bits, BTN_TRIGGER, true);
+            setBit(bits, BTN_THUMB, true);
+        }
+        return 0;
+    }
+    if (nr >= _IOC_NR(EVIOCGABS(0)) && nr < _IOC_NR(EVIOCGABS(0)) + ABS_CNT)
+    {
+        struct input_absinfo *abs = static_cast<struct input_absinfo *>(arg);
+        memset(abs, 0, sizeof(*abs));
+        abs->value = absValue[nr - _IOC_NR(EVIOCGABS(0))];
+        abs->minimum = -32767;
+        abs->maximum = 32767;
+        return 0;
+    }
+
+    return syscall(SYS_ioctl, fd, request, arg);
+}
+
+static struct input_event event(unsigned short type, unsigned short code, int value)
+{
+    struct input_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = type;
+    ev.code = code;
+    ev.value = value;
+    return ev;
+}
+
+// Pops every button transition queued within a second, until @count of them came
+static std::vector<ButtonEvent> takeButtons(Joystick &joystick, std::size_t count)
+{
+    std::vector<ButtonEvent> buttons;
+    ButtonEvent button;
+
+    for (int i = 0; i < 100 && buttons.size() < count; i++)
+    {
+        while (joystick.nextButton(button))
+            buttons.push_back(button);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    return buttons;
+}
+
+struct Idle
+{
+    void listen(const std::vector<int> &, unsigned char) {}
+};
+
+TEST_CASE("A release lost in an evdev overflow is recovered on resync", "[evdev]")
+{
+    memset(keyState, 0, sizeof(keyState));
+
+    unlink(DEVICE_PATH.c_str());
+    REQUIRE(mkfifo(DEVICE_PATH.c_str(), 0600) == 0);
+    int device = open(DEVICE_PATH.c_str(), O_RDWR);
+    REQUIRE(device != -1);
+
+    Joystick joystick(DEVICE_PATH, Joystick::Backend::EVDEV);
+    joystick.connect();
+
+    Idle idle;
+    joystick.startReading(&Idle::listen, &idle);
+
+    // The trigger is pressed
+    setBit(keyState, BTN_TRIGGER, true);
+    std::vector<struct input_event> events = {event(EV_KEY, BTN_TRIGGER, 1), event(EV_SYN, SYN_REPORT, 0)};
+    REQUIRE(write(device, events.data(), events.size() * sizeof(struct input_event)) > 0);
+
+    std::vector<ButtonEvent> buttons = takeButtons(joystick, 1);
+    REQUIRE(buttons.size() == 1);
+    REQUIRE(buttons[0].id == 0);
+    REQUIRE(buttons[0].value == 1);
+
+    // The kernel buffer overflows while it is released: its release falls among the events dropped
+    setBit(keyState, BTN_TRIGGER, false);
+    events = {event(EV_SYN, SYN_DROPPED, 0), event(EV_KEY, BTN_TRIGGER, 0), event(EV_SYN, SYN_REPORT, 0)};
+    REQUIRE(write(device, events.data(), events.size() * sizeof(struct input_event)) > 0);
+
+    buttons = takeButtons(joystick, 1);
+    REQUIRE(buttons.size() == 1);
+    REQUIRE(buttons[0].id == 0);
+    REQUIRE(buttons[0].value == 0);
+
+    // Nothing else changed, nothing else is made up
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ButtonEvent button;
+    REQUIRE_FALSE(joystick.nextButton(button));
+
+    joystick.stopReading();
+    joystick.disconnect();
+
+    close(device);
+    unlink(DEVICE_PATH.c_str());
+}
@@ -0,0 +1,92 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+#include <cctype>
+
+#include "JoystickFrame.hpp"
+
+using namespace Politocean;
+
+TEST_CASE("JoystickFrame survives an encode/decode round trip", "[frame]")
+{
+    JoystickFrame frame;
+    frame.sequence = 65535;
+    frame.timestamp = 1234567890123ULL;
+    frame.setAxes(std::vector<int>{0, -32767, 32767, 100, -1, 40000});
+    frame.setButton(0, true);
+    frame.setButton(20, true);
+    frame.setButton(63, true);
+
+    char buffer[JoystickFrame::MAX_SIZE];
+    std::size_t size = frame.encode(buffer);
+    REQUIRE(size == frame.size());
+
+    JoystickFrame decoded;
+    REQUIRE(JoystickFrame::decode(buffer, size, decoded));
+
+    REQUIRE(decoded.sequence == 65535);
+    REQUIRE(decoded.timestamp == 1234567890123ULL);
+    REQUIRE(decoded.buttons == frame.buttons);
+    REQUIRE(decoded.isPressed(20));
+    REQUIRE_FALSE(decoded.isPressed(21));
+    REQUIRE(decoded.numAxes == 6);
+    REQUIRE(decoded.axes[1] == -32767);
+    REQUIRE(decoded.axes[4] == -1);
+    // Out of range values are clamped to the joydev range
+    REQUIRE(decoded.axes[5] == 32767);
+}
+
+TEST_CASE("JoystickFrame rejects JSON and truncated payloads", "[frame]")
+{
+    JoystickFrame frame, decoded;
+    frame.setAxes(std::vector<int>(4, 7));
+
+    char buffer[JoystickFrame::MAX_SIZE];
+    std::size_t size = frame.encode(buffer);
+
+    REQUIRE_FALSE(JoystickFrame::decode(buffer, size - 1, decoded));
+    REQUIRE_FALSE(JoystickFrame::decode(buffer, size - 4, decoded));
+
+    std::string json = "[1,2,3]";
+    REQUIRE_FALSE(JoystickFrame::isFrame(json));
+    REQUIRE_FALSE(JoystickFrame::decode(json.data(), json.size(), decoded));
+    REQUIRE(JoystickFrame::isFrame(std::string(buffer, size)));
+}
+
+TEST_CASE("An encoded JoystickFrame is printable text, NUL bytes included", "[frame]")
+{
+    // All zero: the raw layout is almost only NUL bytes
+    JoystickFrame frame, decoded;
+    frame.setAxes(std::vector<int>(JoystickFrame::MAX_AXES, 0));
+
+    char buffer[JoystickFrame::MAX_SIZE];
+    std::size_t size = frame.encode(buffer);
+    std::size_t maxSize = JoystickFrame::MAX_SIZE;
+    REQUIRE(size == maxSize);
+
+    // What a client keeping only the C string of the payload would pass on
+    std::string payload(buffer, size);
+    std::string asCString(payload.c_str());
+    REQUIRE(asCString == payload);
+
+    for (char c : payload)
+        REQUIRE(std::isprint((unsigned char)c));
+
+    REQUIRE(JoystickFrame::isFrame(asCString));
+    REQUIRE(JoystickFrame::decode(asCString.data(), asCString.size(), decoded));
+    REQUIRE(decoded.numAxes == frame.numAxes);
+    REQUIRE(decoded.buttons == 0);
+
+    // Every padding length decodes: 20, 22 and 24 raw bytes
+    for (int numAxes = 0; numAxes < 3; numAxes++)
+    {
+        frame.setAxes(std::vector<int>(numAxes, -1));
+        size = frame.encode(buffer);
+        REQUIRE(JoystickFrame::decode(buffer, size, decoded));
+        REQUIRE(decoded.numAxes == numAxes);
+        if (numAxes > 0)
+            REQUIRE(decoded.axes[numAxes - 1] == -1);
+    }
+}
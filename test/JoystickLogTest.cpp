@@ -0,0 +1,220 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "Joystick.h"
+#include "JoystickRecorder.h"
+#include "JoystickPlayer.h"
+
+#include "PolitoceanExceptions.hpp"
+
+#include "SyntheticJoystick.hpp"
+
+using namespace Politocean;
+
+static const std::string DEVICE_PATH = "/tmp/politocean_log_test_js0";
+static const std::string LOG_PATH = "/tmp/politocean_log_test.pjsl";
+static const std::string REPLAY_PATH = "/tmp/politocean_log_test_replay";
+
+static const int NUM_AXES = 4, NUM_BUTTONS = 8;
+
+struct Session
+{
+    std::vector<ButtonEvent> buttons;
+    std::vector<int> axes;
+
+    void listen(const std::vector<int> &values, unsigned char)
+    {
+        axes = values;
+    }
+};
+
+// Reads @joystick until it hangs up, keeping every button transition and the last axes
+static Session readUntilHangUp(Joystick &joystick)
+{
+    Session session;
+    ButtonEvent event;
+
+    joystick.startReading(&Session::listen, &session);
+
+    while (joystick.isConnected() || joystick.isButtonUpdated())
+    {
+        while (joystick.nextButton(event))
+            session.buttons.push_back(event);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    joystick.stopReading();
+
+    return session;
+}
+
+static void recordSession(int steps, int rate, Session &written)
+{
+    SyntheticJoystick device(DEVICE_PATH, NUM_AXES, NUM_BUTTONS);
+    JoystickRecorder recorder;
+    Joystick joystick(device.path());
+    Session read;
+
+    recorder.start(LOG_PATH);
+    joystick.setRecorder(&recorder);
+    joystick.connect();
+    joystick.startReading(&Session::listen, &read);
+
+    auto onStep = [&written](const SyntheticJoystick::Step &step, std::chrono::steady_clock::time_point) {
+        for (const struct js_event &js : step)
+        {
+            if (js.type == JS_EVENT_BUTTON)
+                written.buttons.push_back(ButtonEvent{js.number, (unsigned char)js.value, 0});
+            else
+                written.axes[js.number] = js.value;
+        }
+    };
+
+    written.axes.assign(NUM_AXES, 0);
+
+    device.play(SyntheticJoystick::Pattern::SWEEP, steps, rate, {}, onStep);
+    device.play(SyntheticJoystick::Pattern::BUTTON_MASH, steps, rate, {0, 3, 5}, onStep);
+    device.play(SyntheticJoystick::Pattern::SWEEP, steps, rate, {}, onStep);
+
+    // Let the reading thread drain the FIFO before the recording ends
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    joystick.stopReading();
+    joystick.setRecorder(nullptr);
+    recorder.stop();
+
+    REQUIRE(recorder.getDropped() == 0);
+    REQUIRE(recorder.getRecorded() == (unsigned long)(NUM_AXES + NUM_BUTTONS + 2 * steps * NUM_AXES + steps));
+}
+
+TEST_CASE("A recorded joystick session replays the same events", "[joystick]")
+{
+    const int STEPS = 100;
+    Session written;
+
+    recordSession(STEPS, 1000, written);
+
+    double speed = GENERATE(0.0, 1.0);
+
+    unlink(REPLAY_PATH.c_str());
+    JoystickPlayer player(LOG_PATH, REPLAY_PATH);
+    REQUIRE(player.getEvents() == (std::size_t)(NUM_AXES + NUM_BUTTONS + 2 * STEPS * NUM_AXES + STEPS));
+
+    Joystick joystick(player.getDevice());
+    joystick.connect();
+
+    auto start = std::chrono::steady_clock::now();
+    player.play(speed);
+
+    Session replayed = readUntilHangUp(joystick);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    player.wait();
+
+    REQUIRE(joystick.getDroppedButtons() == 0);
+    REQUIRE(replayed.axes == written.axes);
+    REQUIRE(replayed.buttons.size() == written.buttons.size());
+
+    for (std::size_t i = 0; i < written.buttons.size(); i++)
+    {
+        REQUIRE(replayed.buttons[i].id == written.buttons[i].id);
+        REQUIRE(replayed.buttons[i].value == written.buttons[i].value);
+    }
+
+    // The session took 3 * STEPS ms to record
+    if (speed == 1.0)
+        REQUIRE(seconds >= 0.25);
+    else
+        REQUIRE(seconds < 0.25);
+
+    unlink(LOG_PATH.c_str());
+}
+
+TEST_CASE("Recorded events keep the time the kernel stamped them with", "[joystick]")
+{
+    {
+        SyntheticJoystick device(DEVICE_PATH, NUM_AXES, NUM_BUTTONS);
+        JoystickRecorder recorder;
+        Joystick joystick(device.path());
+        Session read;
+
+        recorder.start(LOG_PATH);
+        joystick.setRecorder(&recorder);
+        joystick.connect();
+        joystick.startReading(&Session::listen, &read);
+
+        // A press and a release 300 ms apart, read at once as if the reading thread had been late
+        SyntheticJoystick::Step step = {SyntheticJoystick::event(JS_EVENT_BUTTON, 2, 1), SyntheticJoystick::event(JS_EVENT_BUTTON, 2, 0)};
+        step[1].time = step[0].time + 300;
+        device.write(step);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        joystick.stopReading();
+        joystick.setRecorder(nullptr);
+        recorder.stop();
+    }
+
+    std::ifstream file(LOG_PATH, std::ios::binary);
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    REQUIRE(data.size() >= JoystickLog::HEADER_SIZE + 2 * JoystickLog::RECORD_SIZE);
+
+    uint32_t delta;
+    struct js_event js;
+    JoystickLog::decodeRecord(data.data() + data.size() - JoystickLog::RECORD_SIZE, delta, js);
+
+    REQUIRE(js.type == JS_EVENT_BUTTON);
+    REQUIRE(js.value == 0);
+    REQUIRE(delta == 300000);
+
+    unlink(LOG_PATH.c_str());
+}
+
+TEST_CASE("A replay device is never put over an existing file", "[joystick]")
+{
+    Session written;
+    recordSession(10, 1000, written);
+
+    std::string device;
+    {
+        JoystickPlayer player(LOG_PATH);
+        device = player.getDevice();
+
+        struct stat info;
+        REQUIRE(stat(device.c_str(), &info) == 0);
+        REQUIRE(S_ISFIFO(info.st_mode));
+
+        // The device is taken: a second player does not replace it
+        REQUIRE_THROWS_AS(JoystickPlayer(LOG_PATH, device), JoystickException);
+    }
+
+    // The device and the directory the player made for it are gone with it
+    REQUIRE(access(device.c_str(), F_OK) == -1);
+    REQUIRE(access(device.substr(0, device.rfind('/')).c_str(), F_OK) == -1);
+
+    unlink(LOG_PATH.c_str());
+}
+
+TEST_CASE("A file which is not a joystick log is refused", "[joystick]")
+{
+    {
+        std::ofstream file(LOG_PATH);
+        file << "[1, 2, 3]";
+    }
+
+    REQUIRE_THROWS_AS(JoystickPlayer(LOG_PATH, REPLAY_PATH), JoystickException);
+    REQUIRE_THROWS_AS(JoystickPlayer("/nonexistent/log.pjsl", REPLAY_PATH), JoystickException);
+
+    unlink(LOG_PATH.c_str());
+}
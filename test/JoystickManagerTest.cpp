@@ -0,0 +1,315 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+#include <set>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <functional>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "PolitoceanConstants.h"
+
+#include "Joystick.h"
+#include "JoystickManager.h"
+#include "ControllerSet.hpp"
+
+#include "SyntheticJoystick.hpp"
+
+using namespace Politocean;
+using namespace Politocean::Constants;
+
+static const std::string DIRECTORY = "/tmp/politocean_manager_test";
+
+static const int NUM_AXES = 4, NUM_BUTTONS = 8;
+
+// What the manager reported, in order
+struct Events
+{
+    std::mutex mutex;
+    std::vector<std::string> attached, detached;
+
+    std::vector<std::string> getAttached()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return attached;
+    }
+
+    std::vector<std::string> getDetached()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return detached;
+    }
+};
+
+// Buttons held down on every device, as device:number
+struct Pressed
+{
+    std::mutex mutex;
+    std::set<std::string> buttons;
+
+    std::set<std::string> get()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return buttons;
+    }
+};
+
+// Listens to a single device for @pressed
+struct DeviceListener
+{
+    std::string device;
+    Pressed &pressed;
+
+    DeviceListener(const std::string &device, Pressed &pressed) : device(device), pressed(pressed) {}
+
+    void listen(const std::vector<int> &, unsigned char button)
+    {
+        // The last button transition, its value in the top bit
+        if (!(button >> 7))
+            return;
+
+        std::lock_guard<std::mutex> lock(pressed.mutex);
+        pressed.buttons.insert(device + ":" + std::to_string(button & 0x7F));
+    }
+};
+
+// Waits up to a second for @condition to hold
+static bool eventually(std::function<bool()> condition)
+{
+    for (int i = 0; i < 100; i++)
+    {
+        if (condition())
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    return condition();
+}
+
+static void watch(JoystickManager &manager, Events &events)
+{
+    manager.onAttach([&events](Joystick &joystick) {
+        std::lock_guard<std::mutex> lock(events.mutex);
+        events.attached.push_back(joystick.getDevice());
+    });
+    manager.onDetach([&events](Joystick &joystick) {
+        std::lock_guard<std::mutex> lock(events.mutex);
+        events.detached.push_back(joystick.getDevice());
+    });
+}
+
+TEST_CASE("Joysticks are attached as they are plugged in and detached as they are unplugged", "[manager]")
+{
+    mkdir(DIRECTORY.c_str(), 0700);
+
+    JoystickManager manager(DIRECTORY);
+    Events events;
+    watch(manager, events);
+
+    manager.start();
+    REQUIRE(manager.getDevices().empty());
+
+    {
+        SyntheticJoystick js0(DIRECTORY + "/js0", NUM_AXES, NUM_BUTTONS);
+
+        REQUIRE(eventually([&]() { return manager.getDevices().size() == 1; }));
+        REQUIRE(events.getAttached() == std::vector<std::string>{DIRECTORY + "/js0"});
+        REQUIRE(events.getDetached().empty());
+    }
+
+    REQUIRE(eventually([&]() { return manager.getDevices().empty(); }));
+    REQUIRE(events.getDetached() == std::vector<std::string>{DIRECTORY + "/js0"});
+
+    manager.stop();
+}
+
+TEST_CASE("Several joysticks are attached at once, each one reading its own events", "[manager]")
+{
+    mkdir(DIRECTORY.c_str(), 0700);
+
+    // js0 is already there when the manager starts, js1 comes later
+    std::unique_ptr<SyntheticJoystick> js0(new SyntheticJoystick(DIRECTORY + "/js0", NUM_AXES, NUM_BUTTONS));
+
+    JoystickManager manager(DIRECTORY);
+    Events events;
+
+    Pressed pressed;
+    std::list<DeviceListener> listeners;
+
+    manager.onAttach([&](Joystick &joystick) {
+        {
+            std::lock_guard<std::mutex> lock(events.mutex);
+            events.attached.push_back(joystick.getDevice());
+        }
+
+        listeners.emplace_back(joystick.getDevice(), pressed);
+        joystick.startReading(&DeviceListener::listen, &listeners.back());
+    });
+    manager.onDetach([&](Joystick &joystick) {
+        std::lock_guard<std::mutex> lock(events.mutex);
+        events.detached.push_back(joystick.getDevice());
+    });
+
+    manager.start();
+    REQUIRE(eventually([&]() { return manager.getDevices().size() == 1; }));
+
+    SyntheticJoystick js1(DIRECTORY + "/js1", NUM_AXES, NUM_BUTTONS);
+    REQUIRE(eventually([&]() { return manager.getDevices().size() == 2; }));
+
+    // Other nodes in the directory are not joysticks
+    SyntheticJoystick event0(DIRECTORY + "/event0", NUM_AXES, NUM_BUTTONS);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(manager.getDevices().size() == 2);
+
+    js0->write({SyntheticJoystick::event(JS_EVENT_BUTTON, 3, 1)});
+    js1.write({SyntheticJoystick::event(JS_EVENT_BUTTON, 5, 1)});
+
+    REQUIRE(eventually([&]() { return pressed.get().size() == 2; }));
+    REQUIRE(pressed.get() == std::set<std::string>{DIRECTORY + "/js0:3", DIRECTORY + "/js1:5"});
+
+    // Unplugging one of them leaves the other one attached
+    js0.reset();
+    REQUIRE(eventually([&]() { return manager.getDevices().size() == 1; }));
+    REQUIRE(manager.getDevices().front() == DIRECTORY + "/js1");
+
+    manager.stop();
+
+    REQUIRE(manager.getDevices().empty());
+    REQUIRE(events.getDetached() == std::vector<std::string>{DIRECTORY + "/js0", DIRECTORY + "/js1"});
+}
+
+TEST_CASE("A reused slot does not replay the presses of its previous device", "[manager]")
+{
+    mkdir(DIRECTORY.c_str(), 0700);
+
+    JoystickManager manager(DIRECTORY);
+
+    Pressed pressed;
+    std::list<DeviceListener> listeners;
+
+    // Whether each joystick still had a transition queued when it was attached
+    std::mutex mutex;
+    std::vector<bool> isStale;
+
+    manager.onAttach([&](Joystick &joystick) {
+        ButtonEvent event;
+        bool hasStale = joystick.nextButton(event);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isStale.push_back(hasStale);
+        }
+
+        // Presses are listened to, never taken from the queue
+        listeners.emplace_back(joystick.getDevice(), pressed);
+        joystick.startReading(&DeviceListener::listen, &listeners.back());
+    });
+
+    manager.start();
+
+    {
+        SyntheticJoystick js0(DIRECTORY + "/js0", NUM_AXES, NUM_BUTTONS);
+        REQUIRE(eventually([&]() { return manager.getDevices().size() == 1; }));
+
+        js0.write({SyntheticJoystick::event(JS_EVENT_BUTTON, 0, 1)});
+        REQUIRE(eventually([&]() { return pressed.get().count(DIRECTORY + "/js0:0") == 1; }));
+    }
+
+    REQUIRE(eventually([&]() { return manager.getDevices().empty(); }));
+
+    // The only slot free is the one js0 left
+    SyntheticJoystick js1(DIRECTORY + "/js1", NUM_AXES, NUM_BUTTONS);
+    REQUIRE(eventually([&]() { return manager.getDevices().size() == 1; }));
+
+    manager.stop();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    REQUIRE(isStale == std::vector<bool>{false, false});
+}
+
+// A broker connection which keeps the topics it was given
+struct TopicClient
+{
+    std::mutex mutex;
+    std::set<std::string> topics;
+
+    void publish(const std::string &topic, const std::string &)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        topics.insert(topic);
+    }
+
+    bool is_connected()
+    {
+        return true;
+    }
+
+    bool isPublished(const std::string &topic)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return topics.count(topic) == 1;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        topics.clear();
+    }
+};
+
+TEST_CASE("A controller still plugged in takes over when the pilot is unplugged", "[manager]")
+{
+    mkdir(DIRECTORY.c_str(), 0700);
+
+    std::unique_ptr<SyntheticJoystick> js0(new SyntheticJoystick(DIRECTORY + "/js0", NUM_AXES, NUM_BUTTONS));
+
+    TopicClient client;
+    JoystickPublisher::ControllerSet<TopicClient> controllers(client);
+
+    std::mutex mutex;
+    std::vector<std::string> pilots;
+    controllers.onPilot([&](const std::string &device) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pilots.push_back(device);
+    });
+
+    auto getPilots = [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pilots;
+    };
+
+    JoystickManager manager(DIRECTORY);
+    manager.onAttach([&](Joystick &joystick) { controllers.attach(joystick); });
+    manager.onDetach([&](Joystick &joystick) { controllers.detach(joystick); });
+
+    manager.start();
+    REQUIRE(eventually([&]() { return manager.getDevices().size() == 1; }));
+
+    SyntheticJoystick js1(DIRECTORY + "/js1", NUM_AXES, NUM_BUTTONS);
+    REQUIRE(eventually([&]() { return manager.getDevices().size() == 2; }));
+
+    // The co-pilot publishes on its own topics
+    js1.write({SyntheticJoystick::event(JS_EVENT_BUTTON, 2, 1)});
+    REQUIRE(eventually([&]() { return client.isPublished(Topics::JOYSTICK_BUTTONS + "js1/"); }));
+
+    js0.reset();
+    REQUIRE(eventually([&]() { return getPilots().size() == 2; }));
+    REQUIRE(getPilots() == std::vector<std::string>{DIRECTORY + "/js0", DIRECTORY + "/js1"});
+
+    // From now on it is the one on the pilot topics
+    client.clear();
+    js1.write({SyntheticJoystick::event(JS_EVENT_BUTTON, 2, 0)});
+    REQUIRE(eventually([&]() { return client.isPublished(Topics::JOYSTICK_BUTTONS); }));
+    REQUIRE_FALSE(client.isPublished(Topics::JOYSTICK_BUTTONS + "js1/"));
+
+    manager.stop();
+
+    REQUIRE(getPilots().back().empty());
+}
@@ -0,0 +1,121 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <vector>
+#include <thread>
+
+#include "LatencyHistogram.hpp"
+#include "Diagnostics.hpp"
+
+using namespace Politocean;
+
+TEST_CASE("Latency histogram percentiles", "[diagnostics]")
+{
+    LatencyHistogram histogram;
+
+    SECTION("An empty histogram summarizes to zero")
+    {
+        LatencyHistogram::Summary summary = histogram.summary();
+
+        REQUIRE(summary.count == 0);
+        REQUIRE(summary.p50 == 0);
+        REQUIRE(summary.p99 == 0);
+        REQUIRE(summary.max == 0);
+    }
+
+    SECTION("Small values are exact")
+    {
+        for (uint64_t value = 1; value <= 10; value++)
+            histogram.record(value);
+
+        LatencyHistogram::Summary summary = histogram.summary();
+
+        REQUIRE(summary.count == 10);
+        REQUIRE(summary.p50 == 5);
+        REQUIRE(summary.p99 == 10);
+        REQUIRE(summary.max == 10);
+    }
+
+    SECTION("Large values are within the bucket precision")
+    {
+        // 1 us to 100 ms
+        for (uint64_t value = 1; value <= 100000; value++)
+            histogram.record(value * 1000);
+
+        LatencyHistogram::Summary summary = histogram.summary();
+        const double precision = 1.0 / LatencyHistogram::SUB_BUCKETS;
+
+        REQUIRE(summary.count == 100000);
+        REQUIRE(summary.max == 100000000);
+        REQUIRE(summary.p50 >= 50000000);
+        REQUIRE(summary.p50 <= 50000000 * (1 + precision));
+        REQUIRE(summary.p99 >= 99000000);
+        REQUIRE(summary.p99 <= summary.max);
+    }
+
+    SECTION("Huge values land in the last bucket")
+    {
+        histogram.record(1ULL << 50);
+
+        LatencyHistogram::Summary summary = histogram.summary();
+
+        REQUIRE(summary.count == 1);
+        REQUIRE(summary.max == 1ULL << 50);
+    }
+
+    SECTION("A summary starts a new interval only when asked to")
+    {
+        histogram.record(1000);
+
+        REQUIRE(histogram.summary(false).count == 1);
+        REQUIRE(histogram.summary().count == 1);
+        REQUIRE(histogram.summary().count == 0);
+    }
+}
+
+TEST_CASE("Latency histogram under concurrent recording", "[diagnostics]")
+{
+    LatencyHistogram histogram;
+
+    const int THREADS = 4, RECORDS = 100000;
+    std::vector<std::thread> recorders;
+    uint64_t counted = 0;
+
+    for (int t = 0; t < THREADS; t++)
+        recorders.emplace_back([&histogram, t]() {
+            for (int i = 0; i < RECORDS; i++)
+                histogram.record((t + 1) * 1000 + i % 100);
+        });
+
+    // Summaries taken meanwhile never lose a value
+    for (int i = 0; i < 100; i++)
+        counted += histogram.summary().count;
+
+    for (std::thread &recorder : recorders)
+        recorder.join();
+
+    counted += histogram.summary().count;
+
+    REQUIRE(counted == THREADS * RECORDS);
+}
+
+TEST_CASE("Diagnostics report", "[diagnostics]")
+{
+    LatencyHistogram &histogram = Diagnostics::histogram("test.latency");
+
+    REQUIRE(&histogram == &Diagnostics::histogram("test.latency"));
+
+    histogram.record(2000);
+    histogram.record(4000);
+
+    auto j_report = nlohmann::json::parse(Diagnostics::report("DiagnosticsTest", 1000));
+
+    REQUIRE(j_report["source"] == "DiagnosticsTest");
+    REQUIRE(j_report["period"] == 1000);
+    REQUIRE(j_report["histograms"]["test.latency"]["count"] == 2);
+    REQUIRE(j_report["histograms"]["test.latency"]["max"] == 4.0);
+
+    // The next report covers a new period
+    j_report = nlohmann::json::parse(Diagnostics::report("DiagnosticsTest", 1000));
+    REQUIRE(j_report["histograms"]["test.latency"]["count"] == 0);
+}
@@ -0,0 +1,308 @@
+/**
+ * End-to-end latency benchmark of the joystick pipeline, with no stick and no broker:
+ *
+ *  SyntheticJoystick -> Joystick -> JoystickPublisher::Listener -> JoystickPublisher::Talker
+ *      -> InProcessBroker (HMI) -> CommandParser::Listener -> CommandParser::Talker -> InProcessBroker (ROV)
+ *
+ * With --local the joystick talker hands its updates to the CommandParser::Listener through a
+ * LocalBridge instead, as PolitoceanJoystickCommands does, and the HMI broker only monitors them.
+ *
+ * Each scripted step is timestamped when it is written, each message when it is published, and
+ * they are matched by content: axis X values are unique within a sweep, and every mashed button
+ * sends exactly one command per transition.
+ *
+ * Usage: PipelineBenchmark [--binary] [--local] [seconds per pattern]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include <time.h>
+#include <stdlib.h>
+
+#include <json.hpp>
+
+#include "PolitoceanConstants.h"
+
+#include "Joystick.h"
+#include "JoystickPublisher.hpp"
+#include "CommandParser.hpp"
+
+#include "SyntheticJoystick.hpp"
+#include "LocalBridge.hpp"
+#include "InProcessBroker.hpp"
+
+using namespace Politocean;
+using namespace Politocean::Constants;
+using namespace Politocean::Constants::Commands;
+
+using std::chrono::steady_clock;
+typedef steady_clock::time_point time_point_t;
+
+static const std::string DEVICE_PATH = "/tmp/politocean_synthetic_js0";
+static const int NUM_AXES = 8, NUM_BUTTONS = 32;
+
+// Buttons which send a command both on press and on release
+static const std::vector<int> MASH_BUTTONS = {Buttons::VUP, Buttons::VUP_FAST, Buttons::VDOWN, Buttons::WRIST, Buttons::HAND};
+
+static double processCpuSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double micros(time_point_t from, time_point_t to)
+{
+    return std::chrono::duration<double, std::micro>(to - from).count();
+}
+
+/**
+ * Matches steps, joystick messages and commands as they go through the pipeline.
+ * Observers run on the broker delivery threads, steps on the main one: all of it is guarded by @mutex_.
+ */
+class Trace
+{
+    std::mutex mutex_;
+
+    // Write time of each axis X value and button transition not published yet
+    std::map<int, time_point_t> axisWrites_, buttonWrites_;
+
+    // Write and publish time of each axis X value published and not commanded yet
+    std::map<int, std::pair<time_point_t, time_point_t>> axisPublishes_;
+
+    // Write and publish time of the button transitions waiting for their command, in order
+    std::deque<std::pair<time_point_t, time_point_t>> buttonPublishes_;
+
+    JoystickFrame frame_;
+
+    void axisPublished(int x, time_point_t published)
+    {
+        auto it = axisWrites_.find(x);
+        if (it == axisWrites_.end())
+            return;
+
+        inputToPublish.push_back(micros(it->second, published));
+        axisPublishes_[x] = std::make_pair(it->second, published);
+        axisWrites_.erase(it);
+    }
+
+    void buttonPublished(int id, int value, time_point_t published)
+    {
+        auto it = buttonWrites_.find(id << 1 | value);
+        if (it == buttonWrites_.end())
+            return;
+
+        inputToPublish.push_back(micros(it->second, published));
+        buttonPublishes_.push_back(std::make_pair(it->second, published));
+        buttonWrites_.erase(it);
+    }
+
+    void commanded(const std::pair<time_point_t, time_point_t> &times, time_point_t published)
+    {
+        publishToCommand.push_back(micros(times.second, published));
+        inputToCommand.push_back(micros(times.first, published));
+    }
+
+public:
+    int steps = 0, messages = 0, commands = 0;
+    std::vector<double> inputToPublish, publishToCommand, inputToCommand;
+
+    void onStep(const SyntheticJoystick::Step &step, time_point_t written)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        steps++;
+        for (const struct js_event &js : step)
+        {
+            if (js.type == JS_EVENT_AXIS && js.number == Axes::X)
+                axisWrites_[js.value] = written;
+            else if (js.type == JS_EVENT_BUTTON)
+                buttonWrites_[js.number << 1 | js.value] = written;
+        }
+    }
+
+    void onJoystickMessage(const InProcessBroker::Message &message)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        messages++;
+
+        if (message.topic == Topics::JOYSTICK_AXES)
+        {
+            auto j_axes = nlohmann::json::parse(message.payload);
+            if (j_axes.size() > (std::size_t)Axes::X)
+                axisPublished(j_axes[Axes::X].get<int>(), message.published);
+        }
+        else if (message.topic == Topics::JOYSTICK_BUTTONS)
+        {
+            Button button = Button::parse(message.payload);
+            buttonPublished(button.getId(), button.getValue(), message.published);
+        }
+        else if (message.topic == JOYSTICK_FRAME_TOPIC)
+        {
+            JoystickFrame frame;
+            if (!JoystickFrame::decode(message.payload.data(), message.payload.size(), frame))
+                return;
+
+            if (frame.numAxes > Axes::X)
+                axisPublished(frame.axes[Axes::X], message.published);
+
+            uint64_t changed = frame.buttons ^ frame_.buttons;
+            for (int id = 0; changed; id++, changed >>= 1)
+                if (changed & 1)
+                    buttonPublished(id, frame.isPressed(id), message.published);
+
+            frame_ = frame;
+        }
+    }
+
+    void onCommand(const InProcessBroker::Message &message)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        commands++;
+
+        if (message.topic == Topics::AXES)
+        {
+            int x = nlohmann::json::parse(message.payload)[0].get<int>();
+
+            auto it = axisPublishes_.find(x);
+            if (it == axisPublishes_.end())
+                return;
+
+            commanded(it->second, message.published);
+            axisPublishes_.erase(it);
+        }
+        else if (message.topic == Topics::COMMANDS || message.topic == Topics::WRIST || message.topic == Topics::HAND)
+        {
+            if (buttonPublishes_.empty())
+                return;
+
+            commanded(buttonPublishes_.front(), message.published);
+            buttonPublishes_.pop_front();
+        }
+    }
+};
+
+static void report(const std::string &name, std::vector<double> &latencies, int expected)
+{
+    std::cout << "  " << std::left << std::setw(20) << name << std::right;
+
+    if (latencies.empty())
+    {
+        std::cout << std::setw(10) << 0 << " / " << expected << std::endl;
+        return;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << std::setw(10) << latencies.size() << " / " << std::left << std::setw(8) << expected << std::right
+              << std::fixed << std::setprecision(1)
+              << std::setw(12) << latencies[latencies.size() / 2]
+              << std::setw(12) << latencies[latencies.size() * 99 / 100]
+              << std::setw(12) << latencies.back() << std::endl;
+}
+
+static void run(const std::string &name, SyntheticJoystick::Pattern pattern, int rate, double seconds, JoystickPublisher::WireFormat wireFormat, bool isLocal)
+{
+    SyntheticJoystick device(DEVICE_PATH, NUM_AXES, NUM_BUTTONS);
+    InProcessBroker hmi, rov;
+    Trace trace;
+
+    Joystick joystick(device.path());
+    JoystickPublisher::Listener joystickListener(joystick);
+    JoystickPublisher::Talker joystickTalker;
+
+    CommandParser::Listener commandListener;
+    CommandParser::Talker commandTalker;
+
+    joystickTalker.setWireFormat(wireFormat);
+
+    CommandParser::LocalBridge<InProcessBroker> bridge(commandListener, &hmi);
+
+    if (!isLocal)
+    {
+        hmi.subscribeTo(Topics::JOYSTICK_BUTTONS, &CommandParser::Listener::listenForButtons, &commandListener);
+        hmi.subscribeTo(Topics::JOYSTICK_AXES, &CommandParser::Listener::listenForAxes, &commandListener);
+        hmi.subscribeTo(JOYSTICK_FRAME_TOPIC, &CommandParser::Listener::listenForFrame, &commandListener);
+    }
+
+    hmi.observe([&](const InProcessBroker::Message &message) { trace.onJoystickMessage(message); });
+    rov.observe([&](const InProcessBroker::Message &message) { trace.onCommand(message); });
+
+    joystick.connect();
+    joystick.startReading(&JoystickPublisher::Listener::listen, &joystickListener);
+    if (isLocal)
+        joystickTalker.startTalking(bridge, joystickListener);
+    else
+        joystickTalker.startTalking(hmi, joystickListener);
+    commandTalker.startTalking(rov, commandListener);
+
+    // Let the initial state go through before timing anything
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    int count = seconds * rate;
+    double cpuStart = processCpuSeconds();
+
+    device.play(pattern, count, rate, MASH_BUTTONS, [&](const SyntheticJoystick::Step &step, time_point_t written) {
+        trace.onStep(step, written);
+    });
+
+    double cpuUsage = (processCpuSeconds() - cpuStart) / seconds;
+
+    // Whatever is still in flight is given the time to land
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    joystickTalker.stopTalking();
+    joystick.stopReading();
+    commandTalker.stopTalking();
+    hmi.disconnect();
+    rov.disconnect();
+
+    std::cout << name << ": " << trace.steps << " steps, " << trace.messages << " joystick messages, "
+              << trace.commands << " commands, " << std::fixed << std::setprecision(1) << cpuUsage * 100 << "% CPU" << std::endl;
+
+    std::cout << "  " << std::left << std::setw(20) << "" << std::right << std::setw(21) << "matched"
+              << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(12) << "max us" << std::endl;
+
+    report("input -> publish", trace.inputToPublish, trace.steps);
+    report("publish -> command", trace.publishToCommand, trace.inputToPublish.size());
+    report("input -> command", trace.inputToCommand, trace.steps);
+
+    std::cout << std::endl;
+}
+
+int main(int argc, const char *argv[])
+{
+    JoystickPublisher::WireFormat wireFormat = JoystickPublisher::WireFormat::JSON;
+    double seconds = 3;
+    bool isLocal = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--binary")
+            wireFormat = JoystickPublisher::WireFormat::BINARY;
+        else if (std::string(argv[i]) == "--local")
+            isLocal = true;
+        else
+            seconds = atof(argv[i]);
+    }
+
+    std::cout << (wireFormat == JoystickPublisher::WireFormat::BINARY ? "Binary" : "JSON") << " wire format, "
+              << (isLocal ? "local bridge, " : "HMI broker, ") << seconds << " s per pattern\n\n";
+
+    run("Idle", SyntheticJoystick::Pattern::IDLE, 100, seconds, wireFormat, isLocal);
+    run("Full-stick sweeps at 500 Hz", SyntheticJoystick::Pattern::SWEEP, 500, seconds, wireFormat, isLocal);
+    run("Button mashing at 40 transitions/s", SyntheticJoystick::Pattern::BUTTON_MASH, 40, seconds, wireFormat, isLocal);
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+#ifndef PSEUDO_TERMINAL_H
+#define PSEUDO_TERMINAL_H
+
+#include <string>
+#include <stdexcept>
+
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * A pty pair standing in for a serial device: Serial opens @device(),
+ * the test drives the other end through @master().
+ */
+class PseudoTerminal
+{
+    int master_;
+    std::string device_;
+
+public:
+    PseudoTerminal()
+    {
+        if ((master_ = posix_openpt(O_RDWR | O_NOCTTY)) < 0 || grantpt(master_) < 0 || unlockpt(master_) < 0)
+            throw std::runtime_error("Cannot open pseudo-terminal.");
+
+        device_ = ptsname(master_);
+    }
+
+    ~PseudoTerminal()
+    {
+        hangUp();
+    }
+
+    // Closes the master side, as unplugging a device does
+    void hangUp()
+    {
+        if (master_ >= 0)
+            close(master_);
+        master_ = -1;
+    }
+
+    int master() const { return master_; }
+    const std::string &device() const { return device_; }
+
+    void write(const std::string &data)
+    {
+        std::size_t written = 0;
+        while (written < data.size())
+        {
+            ssize_t n = ::write(master_, data.data() + written, data.size() - written);
+            if (n < 0)
+                throw std::runtime_error("Cannot write pseudo-terminal.");
+            written += n;
+        }
+    }
+};
+
+#endif //PSEUDO_TERMINAL_H
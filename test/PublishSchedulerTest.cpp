@@ -0,0 +1,129 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <chrono>
+
+#include <json.hpp>
+
+#include "PolitoceanConstants.h"
+
+#include "CommandParser.hpp"
+#include "PublishScheduler.hpp"
+#include "Diagnostics.hpp"
+
+using namespace Politocean;
+using namespace Politocean::Constants;
+using namespace Politocean::Constants::Commands;
+using namespace Politocean::CommandParser;
+
+// A broker link which takes @delay to send each message
+struct SlowClient
+{
+    struct Sent
+    {
+        std::string topic, payload;
+    };
+
+    std::chrono::milliseconds delay;
+
+    std::mutex mutex;
+    std::vector<Sent> sent;
+
+    SlowClient(int delay) : delay(delay) {}
+
+    void publish(const std::string &topic, const std::string &payload)
+    {
+        std::this_thread::sleep_for(delay);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        sent.push_back(Sent{topic, payload});
+    }
+
+    bool is_connected()
+    {
+        return true;
+    }
+};
+
+static const std::vector<std::string> AXES_TOPICS = {Topics::AXES, Topics::SHOULDER_VELOCITY, Topics::WRIST_VELOCITY, Topics::HAND_VELOCITY};
+
+TEST_CASE("A stop is not stuck behind a burst of stick data", "[scheduler]")
+{
+    SlowClient rov(5);
+    PublishScheduler scheduler;
+
+    scheduler.start(rov);
+
+    // A second of stick data at 250 Hz comes in at once
+    for (int i = 0; i < 250; i++)
+        for (const std::string &topic : AXES_TOPICS)
+            scheduler.push(Priority::AXES, topic, std::to_string(i));
+
+    scheduler.push(Priority::SAFETY, Topics::COMMANDS, Actions::ATMega::START_AND_STOP);
+
+    scheduler.stop();
+
+    // At most one axes message was on its way when the stop came
+    REQUIRE(rov.sent.size() <= AXES_TOPICS.size() + 2);
+    REQUIRE((rov.sent[0].topic == Topics::COMMANDS || rov.sent[1].topic == Topics::COMMANDS));
+
+    // The rest are the newest value of each topic, the stale ones are gone
+    for (const SlowClient::Sent &sent : rov.sent)
+        if (sent.topic != Topics::COMMANDS && sent.payload != "0")
+            REQUIRE(sent.payload == "249");
+
+    REQUIRE(scheduler.getStale() >= 250 * AXES_TOPICS.size() - AXES_TOPICS.size() - 1);
+}
+
+TEST_CASE("Commands keep their order and are never dropped as stale", "[scheduler]")
+{
+    SlowClient rov(1);
+    PublishScheduler scheduler;
+
+    scheduler.start(rov);
+
+    for (int i = 0; i < 20; i++)
+        scheduler.push(Priority::COMMANDS, Topics::COMMANDS, std::to_string(i));
+
+    scheduler.stop();
+
+    REQUIRE(rov.sent.size() == 20);
+    for (int i = 0; i < 20; i++)
+        REQUIRE(rov.sent[i].payload == std::to_string(i));
+}
+
+TEST_CASE("Emergency stop, motor power and reset are safety commands", "[scheduler]")
+{
+    REQUIRE(priorityOf(ButtonAction{Topics::COMMANDS, Actions::ATMega::START_AND_STOP}) == Priority::SAFETY);
+    REQUIRE(priorityOf(ButtonAction{Topics::COMMANDS, Actions::OFF}) == Priority::SAFETY);
+    REQUIRE(priorityOf(ButtonAction{Topics::COMMANDS, Actions::ON}) == Priority::SAFETY);
+    REQUIRE(priorityOf(ButtonAction{Topics::COMMANDS, Actions::RESET}) == Priority::SAFETY);
+
+    REQUIRE(priorityOf(ButtonAction{Topics::COMMANDS, Actions::ATMega::VUP_ON}) == Priority::COMMANDS);
+    REQUIRE(priorityOf(ButtonAction{Topics::SHOULDER, Actions::OFF}) == Priority::COMMANDS);
+}
+
+TEST_CASE("Queueing delays are reported per class", "[scheduler]")
+{
+    SlowClient rov(0);
+    PublishScheduler scheduler;
+
+    Diagnostics::report("PublishSchedulerTest", 1000);
+
+    scheduler.start(rov);
+    scheduler.push(Priority::SAFETY, Topics::COMMANDS, Actions::ATMega::START_AND_STOP);
+    scheduler.push(Priority::AXES, Topics::AXES, "[1,2,3,4]");
+    scheduler.push(Priority::AXES, Topics::AXES, "[5,6,7,8]");
+    scheduler.stop();
+
+    auto j_report = nlohmann::json::parse(Diagnostics::report("PublishSchedulerTest", 1000));
+
+    REQUIRE(j_report["histograms"]["commands.queue.safety"]["count"] == 1);
+    REQUIRE(j_report["histograms"]["commands.queue.commands"]["count"] == 0);
+    REQUIRE(j_report["histograms"]["commands.queue.axes"]["count"] >= 1);
+    REQUIRE(j_report["counters"]["commands.stale"] == scheduler.getStale());
+}
@@ -0,0 +1,158 @@
+/**
+ * Serial throughput benchmark over a pseudo-terminal.
+ * A synthetic sensor writes timestamped lines into the pty at a given rate,
+ * Serial reads them back with each of its read functions.
+ *
+ * Usage: SerialBenchmark [lines] [line length] [lines per second, 0 = as fast as possible]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Serial.h"
+
+#include "PseudoTerminal.hpp"
+
+using std::chrono::steady_clock;
+
+static uint64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Writes @lines lines of @length bytes, each one starting with its send time in ns.
+ */
+static void emit(PseudoTerminal &pty, int lines, int length, int rate)
+{
+    std::string line;
+    steady_clock::time_point start = steady_clock::now();
+
+    for (int i = 0; i < lines; i++)
+    {
+        if (rate > 0)
+            std::this_thread::sleep_until(start + std::chrono::microseconds(1000000LL * i / rate));
+
+        line = std::to_string(nowNs()) + " ";
+        line.resize(std::max<std::size_t>(length - 1, line.size()), 'x');
+        line.push_back('\n');
+
+        pty.write(line);
+    }
+}
+
+struct Result
+{
+    double seconds;
+    long bytes;
+    unsigned long syscalls;
+    std::vector<double> latencies;
+};
+
+/**
+ * Reads @lines lines with @readLine, which returns the bytes consumed and the send time of each line read.
+ */
+static Result run(int lines, int length, int rate, const std::function<int(Serial &, std::vector<uint64_t> &)> &readLine)
+{
+    PseudoTerminal pty;
+    Serial serial(pty.device(), BaudRate::B_115200);
+    serial.open();
+
+    Result result = {0, 0, 0, {}};
+    result.latencies.reserve(lines);
+
+    std::vector<uint64_t> sent;
+    sent.reserve(64);
+
+    std::thread emitter(emit, std::ref(pty), lines, length, rate);
+
+    steady_clock::time_point start = steady_clock::now();
+
+    while ((int)result.latencies.size() < lines)
+    {
+        sent.clear();
+        result.bytes += readLine(serial, sent);
+
+        uint64_t now = nowNs();
+        for (uint64_t time : sent)
+            result.latencies.push_back((now - time) / 1000.0);
+    }
+
+    result.seconds = std::chrono::duration<double>(steady_clock::now() - start).count();
+    result.syscalls = serial.getReadCalls();
+
+    emitter.join();
+
+    return result;
+}
+
+static void report(const std::string &name, Result &result, int lines)
+{
+    std::sort(result.latencies.begin(), result.latencies.end());
+
+    std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(12) << lines / result.seconds
+              << std::setw(14) << result.bytes / result.seconds / 1024
+              << std::setw(12) << (double)result.syscalls / lines
+              << std::setw(12) << result.latencies[lines / 2]
+              << std::setw(12) << result.latencies[lines * 99 / 100] << std::endl;
+}
+
+int main(int argc, const char *argv[])
+{
+    int lines = argc > 1 ? atoi(argv[1]) : 100000;
+    int length = argc > 2 ? atoi(argv[2]) : 32;
+    int rate = argc > 3 ? atoi(argv[3]) : 0;
+
+    std::cout << lines << " lines of " << length << " bytes at " << (rate ? std::to_string(rate) + " lines/s" : "full speed") << "\n\n";
+    std::cout << std::left << std::setw(24) << "" << std::right
+              << std::setw(12) << "lines/s" << std::setw(14) << "KiB/s" << std::setw(12) << "reads/line"
+              << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::endl;
+
+    Result result = run(lines, length, rate, [](Serial &serial, std::vector<uint64_t> &sent) {
+        SerialLine line;
+        int size = serial.readLine(line);
+        if (size > 0)
+            sent.push_back(strtoull(line.data, nullptr, 10));
+        return size;
+    });
+    report("readLine(SerialLine &)", result, lines);
+
+    result = run(lines, length, rate, [](Serial &serial, std::vector<uint64_t> &sent) {
+        std::string line;
+        int size = serial.readLine(line);
+        sent.push_back(strtoull(line.c_str(), nullptr, 10));
+        return size;
+    });
+    report("readLine(std::string &)", result, lines);
+
+    // read() returns chunks: only whole lines are timed, the tail is kept for the next chunk
+    std::string partial;
+    result = run(lines, length, rate, [&partial](Serial &serial, std::vector<uint64_t> &sent) {
+        std::string chunk;
+        int size = serial.read(chunk);
+        partial += chunk;
+
+        std::size_t begin = 0, end;
+        while ((end = partial.find('\n', begin)) != std::string::npos)
+        {
+            sent.push_back(strtoull(partial.c_str() + begin, nullptr, 10));
+            begin = end + 1;
+        }
+        partial.erase(0, begin);
+
+        return size;
+    });
+    report("read(std::string &)", result, lines);
+
+    return 0;
+}
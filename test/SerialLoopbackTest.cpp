@@ -0,0 +1,197 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <chrono>
+
+#include "Serial.h"
+#include "SerialEventLoop.h"
+
+#include "PseudoTerminal.hpp"
+
+TEST_CASE("Serial reassembles lines split across writes", "[serial]")
+{
+    PseudoTerminal pty;
+    Serial serial(pty.device());
+    serial.open();
+
+    pty.write("ph 7.0");
+    pty.write("1\nph 6.9");
+    pty.write("8\n");
+
+    std::string line;
+    REQUIRE(serial.readLine(line) == 8);
+    REQUIRE(line == "ph 7.01\n");
+    REQUIRE(serial.readLine(line) == 8);
+    REQUIRE(line == "ph 6.98\n");
+}
+
+TEST_CASE("Serial drains a burst of lines with few syscalls", "[serial]")
+{
+    PseudoTerminal pty;
+    Serial serial(pty.device());
+    serial.open();
+
+    std::string burst;
+    for (int i = 0; i < 100; i++)
+        burst += "line " + std::to_string(i) + "\n";
+    pty.write(burst);
+
+    SerialLine line;
+    for (int i = 0; i < 100; i++)
+    {
+        REQUIRE(serial.readLine(line) > 0);
+        REQUIRE(line.str() == "line " + std::to_string(i) + "\n");
+    }
+
+    REQUIRE(serial.getReadCalls() < 10);
+}
+
+TEST_CASE("Serial keeps a partial line across a timeout", "[serial]")
+{
+    PseudoTerminal pty;
+    Serial serial(pty.device());
+    serial.open();
+    serial.setBlocking(false);
+
+    pty.write("T 2");
+
+    SerialLine line;
+    REQUIRE(serial.readLine(line) == 0);
+
+    pty.write("0.5\nraw");
+    REQUIRE(serial.readLine(line) == 7);
+    REQUIRE(line.str() == "T 20.5\n");
+
+    // Bytes buffered by readLine are not lost by read
+    std::string rest;
+    REQUIRE(serial.read(rest) == 3);
+    REQUIRE(rest == "raw");
+}
+
+TEST_CASE("Serial sleeps while waiting for a line", "[serial]")
+{
+    PseudoTerminal pty;
+    Serial serial(pty.device());
+    serial.open();
+    serial.setBlocking(false);
+
+    pty.write("T 2");
+
+    std::thread writer([&pty]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        pty.write("0.5\n");
+    });
+
+    std::string line;
+    int size = serial.readLine(line);
+
+    writer.join();
+
+    REQUIRE(size == 7);
+    REQUIRE(line == "T 20.5\n");
+
+    // Woken up by the bytes, not spinning on EAGAIN meanwhile
+    REQUIRE(serial.getReadCalls() < 10);
+}
+
+TEST_CASE("Serial stops waiting for a line once the port hangs up", "[serial]")
+{
+    PseudoTerminal pty;
+    Serial serial(pty.device());
+    serial.open();
+
+    pty.write("T 2");
+
+    std::thread unplug([&pty]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        pty.hangUp();
+    });
+
+    std::string line;
+    bool isThrown = false;
+    try
+    {
+        serial.readLine(line);
+    }
+    catch (const SerialException &e)
+    {
+        isThrown = true;
+    }
+
+    unplug.join();
+
+    REQUIRE(isThrown);
+}
+
+TEST_CASE("Serial accepts standard and custom baud rates", "[serial]")
+{
+    PseudoTerminal pty;
+    Serial serial(pty.device(), BaudRate::B_115200);
+    serial.open();
+
+    REQUIRE_NOTHROW(serial.setBaudRate(BaudRate::B_921600));
+    REQUIRE_NOTHROW(serial.setBaudRate(250000u));
+}
+
+TEST_CASE("SerialEventLoop serves several ports from one thread", "[serial]")
+{
+    PseudoTerminal phMeter, depth;
+    Serial phSerial(phMeter.device()), depthSerial(depth.device());
+    phSerial.open();
+    depthSerial.open();
+
+    std::mutex mutex;
+    std::vector<std::string> frames;
+
+    SerialEventLoop loop;
+    loop.add(phSerial, [&](const SerialLine &frame) {
+        std::lock_guard<std::mutex> lock(mutex);
+        frames.push_back("ph:" + frame.str());
+    });
+    loop.add(depthSerial, [&](const SerialLine &frame) {
+        std::lock_guard<std::mutex> lock(mutex);
+        frames.push_back("depth:" + frame.str());
+    }, ';');
+    loop.start();
+
+    phMeter.write("7.0\n");
+    depth.write("1.5;2.");
+    depth.write("5;");
+
+    for (int i = 0; i < 100; i++)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (frames.size() == 3)
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // Outgoing data larger than the pty buffer is queued and flushed by the loop
+    std::string command(64 * 1024, 'c');
+    loop.write(depthSerial, command);
+
+    std::string received;
+    char buffer[4096];
+    while (received.size() < command.size())
+    {
+        ssize_t n = read(depth.master(), buffer, sizeof(buffer));
+        REQUIRE(n > 0);
+        received.append(buffer, n);
+    }
+
+    loop.stop();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    REQUIRE(frames.size() == 3);
+    REQUIRE(std::count(frames.begin(), frames.end(), "ph:7.0\n") == 1);
+    REQUIRE(std::count(frames.begin(), frames.end(), "depth:1.5;") == 1);
+    REQUIRE(std::count(frames.begin(), frames.end(), "depth:2.5;") == 1);
+    REQUIRE(received == command);
+}
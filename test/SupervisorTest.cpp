@@ -0,0 +1,123 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+
+#include <sys/resource.h>
+
+#include "Joystick.h"
+#include "Supervisor.hpp"
+
+#include "SyntheticJoystick.hpp"
+
+using namespace Politocean;
+
+static const std::string DEVICE_PATH = "/tmp/politocean_supervisor_test_js0";
+
+static const int NUM_AXES = 4, NUM_BUTTONS = 8;
+
+// CPU time of the whole process, in milliseconds
+static long cpuTime()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000L + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000L;
+}
+
+// A broker connection whose wait() blocks until drop()
+struct FakeClient
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool isConnected = true;
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]() { return !isConnected; });
+    }
+
+    void drop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isConnected = false;
+        }
+        cv.notify_all();
+    }
+};
+
+// Joystick events are of no interest here
+struct Idle
+{
+    void listen(const std::vector<int> &, unsigned char) {}
+};
+
+TEST_CASE("Backoff doubles the delay up to its maximum", "[supervisor]")
+{
+    Backoff backoff(100, 1000);
+
+    REQUIRE(backoff.next().count() == 100);
+    REQUIRE(backoff.next().count() == 200);
+    REQUIRE(backoff.next().count() == 400);
+    REQUIRE(backoff.next().count() == 800);
+    REQUIRE(backoff.next().count() == 1000);
+    REQUIRE(backoff.next().count() == 1000);
+
+    backoff.reset();
+    REQUIRE(backoff.next().count() == 100);
+}
+
+TEST_CASE("A backoff sleep is cut short by an event", "[supervisor]")
+{
+    Supervisor supervisor;
+
+    REQUIRE(supervisor.waitFor(std::chrono::milliseconds(10)) == 0);
+
+    std::thread notifier([&supervisor]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        supervisor.notify(Supervisor::JOYSTICK_LOST);
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE(supervisor.waitFor(std::chrono::seconds(10)) == Supervisor::JOYSTICK_LOST);
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+    notifier.join();
+}
+
+TEST_CASE("The supervisor sleeps until the joystick hangs up or the broker goes away", "[supervisor]")
+{
+    FakeClient client;
+    Supervisor supervisor;
+
+    std::unique_ptr<SyntheticJoystick> synthetic(new SyntheticJoystick(DEVICE_PATH, NUM_AXES, NUM_BUTTONS));
+
+    Joystick joystick(DEVICE_PATH);
+    joystick.onDisconnect([&supervisor]() { supervisor.notify(Supervisor::JOYSTICK_LOST); });
+    joystick.connect();
+    Idle idle;
+    joystick.startReading(&Idle::listen, &idle);
+
+    supervisor.watch(client, Supervisor::BROKER_LOST);
+
+    // Nothing changes for half a second: nobody may spin meanwhile
+    long cpuStart = cpuTime();
+    REQUIRE(supervisor.waitFor(std::chrono::milliseconds(500)) == 0);
+    REQUIRE(cpuTime() - cpuStart < 50);
+
+    // Closing the FIFO hangs it up, as unplugging a device does
+    synthetic.reset();
+    REQUIRE(supervisor.waitFor(std::chrono::seconds(1)) == Supervisor::JOYSTICK_LOST);
+    REQUIRE_FALSE(joystick.isConnected());
+
+    client.drop();
+    REQUIRE(supervisor.wait() == Supervisor::BROKER_LOST);
+
+    joystick.stopReading();
+}
@@ -0,0 +1,159 @@
+#ifndef SYNTHETIC_JOYSTICK_H
+#define SYNTHETIC_JOYSTICK_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <linux/joystick.h>
+
+/**
+ * Fake joydev device for tests and benchmarks: a FIFO fed with js_events, which a Joystick
+ * opens like /dev/input/js0. It starts with the initial state events a real device sends,
+ * so the Joystick learns the number of axes from them, then plays scripted patterns.
+ */
+class SyntheticJoystick
+{
+public:
+    enum class Pattern
+    {
+        IDLE,       // nothing moves
+        SWEEP,      // every axis sweeps its full range back and forth
+        BUTTON_MASH // @buttons are pressed and released in turn
+    };
+
+    // Events written in a single write(), as a device reports them in one read
+    typedef std::vector<struct js_event> Step;
+    typedef std::function<void(const Step &step, std::chrono::steady_clock::time_point written)> callback_t;
+
+    static const int SWEEP_STEPS = 256;
+
+private:
+    std::string path_;
+    int fd_;
+    int numAxes_;
+
+    static uint32_t millis()
+    {
+        using namespace std::chrono;
+        return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+public:
+    // A single event, stamped with the current time
+    static struct js_event event(unsigned char type, unsigned char number, short value)
+    {
+        struct js_event js;
+        js.time = millis();
+        js.type = type;
+        js.number = number;
+        js.value = value;
+        return js;
+    }
+
+    SyntheticJoystick(const std::string &path, int numAxes, int numButtons) : path_(path), numAxes_(numAxes)
+    {
+        unlink(path_.c_str());
+        if (mkfifo(path_.c_str(), 0600) == -1)
+            throw std::runtime_error("Cannot create synthetic joystick " + path_ + ".");
+
+        // Opened read-write, so that neither side blocks on open and the FIFO never hangs up
+        if ((fd_ = open(path_.c_str(), O_RDWR)) == -1)
+            throw std::runtime_error("Cannot open synthetic joystick " + path_ + ".");
+
+        Step initial;
+        for (int i = 0; i < numAxes; i++)
+            initial.push_back(event(JS_EVENT_AXIS | JS_EVENT_INIT, i, 0));
+        for (int i = 0; i < numButtons; i++)
+            initial.push_back(event(JS_EVENT_BUTTON | JS_EVENT_INIT, i, 0));
+        write(initial);
+    }
+
+    ~SyntheticJoystick()
+    {
+        close(fd_);
+        unlink(path_.c_str());
+    }
+
+    const std::string &path() const
+    {
+        return path_;
+    }
+
+    void write(const Step &step)
+    {
+        if (::write(fd_, step.data(), step.size() * sizeof(struct js_event)) != (ssize_t)(step.size() * sizeof(struct js_event)))
+            throw std::runtime_error("Cannot write to synthetic joystick " + path_ + ".");
+    }
+
+    /**
+     * Builds step @i of @pattern. A sweep moves axis i to the opposite of axis i - 1,
+     * so within SWEEP_STEPS steps no two of them give axis 0 the same value.
+     */
+    Step step(Pattern pattern, int i, const std::vector<int> &buttons) const
+    {
+        Step step;
+
+        switch (pattern)
+        {
+        case Pattern::IDLE:
+            break;
+        case Pattern::SWEEP:
+        {
+            int phase = i % (2 * SWEEP_STEPS);
+            int position = phase < SWEEP_STEPS ? phase : 2 * SWEEP_STEPS - 1 - phase;
+            short value = -32767 + position * (65534 / SWEEP_STEPS);
+
+            // The way back is shifted by one, so that it does not repeat the values of the way out
+            if (phase >= SWEEP_STEPS)
+                value += 1;
+
+            for (int axis = 0; axis < numAxes_; axis++)
+                step.push_back(event(JS_EVENT_AXIS, axis, axis % 2 ? -value : value));
+            break;
+        }
+        case Pattern::BUTTON_MASH:
+            step.push_back(event(JS_EVENT_BUTTON, buttons[(i / 2) % buttons.size()], !(i % 2)));
+            break;
+        }
+
+        return step;
+    }
+
+    /**
+     * Plays @count steps of @pattern at @rate steps per second, calling @onStep with the write time of each one.
+     * An idle pattern just waits for as long as the other ones would take.
+     */
+    void play(Pattern pattern, int count, int rate, const std::vector<int> &buttons = {}, callback_t onStep = nullptr)
+    {
+        using std::chrono::steady_clock;
+
+        steady_clock::time_point start = steady_clock::now();
+
+        for (int i = 0; i < count; i++)
+        {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(1000000LL * i / rate));
+
+            Step next = step(pattern, i, buttons);
+            if (next.empty())
+                continue;
+
+            // @onStep runs first, so that it is done before the step can come out of the pipeline
+            steady_clock::time_point written = steady_clock::now();
+            if (onStep)
+                onStep(next, written);
+
+            write(next);
+        }
+
+        std::this_thread::sleep_until(start + std::chrono::microseconds(1000000LL * count / rate));
+    }
+};
+
+#endif //SYNTHETIC_JOYSTICK_H